@@ -22,3 +22,6 @@ set VK_EXPORT=-EXPORT:win32_load_renderer -EXPORT:win32_end_frame
 call cl %CCFLAGS% %COMMON_DEFINE% -I%VK_INCLUDE_DIR% -Od -LD ..\src\win32_vulkan.cpp -Fe:vulkan.dll /link -libpath:%VK_LIB_DIR% %VK_LIB% %VK_EXPORT% 
 
 popd
+
+:: Shaders ::
+call src\compile_shader.bat || exit /b 1
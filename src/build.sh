@@ -4,6 +4,13 @@
 # Stop at errors.
 set -e
 
+# The renderer loads SPIR-V built from src/shaders, and the .spv files have to
+# match the pipeline layout in this tree, so shaders are always rebuilt.
+if ! command -v glslc > /dev/null; then
+    echo "[ERROR] glslc not found. Install the Vulkan SDK or shaderc so it's on PATH." >&2
+    exit 1
+fi
+
 Compiler=g++
 CC="-O0 -g -ggdb -std=c++17 -fno-exceptions -I../src/vendor -Wall -Wextra -Wno-unused-function"
 #-msse4.2 -maes
@@ -23,5 +30,15 @@ $Compiler $CC -shared -fPIC "$CurDir/linux_vulkan.cpp" -o renderer_vulkan.so -lX
 echo Building LINUX testbed...
 $Compiler $CC "$CurDir/linux.cpp" -o linux -lX11
 
-echo Build Completed.
+echo Building LINUX benchmark...
+$Compiler ${CC/-O0/-O2} "$CurDir/linux_benchmark.cpp" -o benchmark -lpthread
+
+echo Building LINUX replay...
+$Compiler $CC "$CurDir/linux_replay.cpp" -o replay -lX11
+
 popd > /dev/null
+
+echo Compiling shaders...
+"$CurDir/compile_shader.sh"
+
+echo Build Completed.
@@ -1,6 +1,17 @@
 @echo off
+setlocal
+cd /d "%~dp0"
 
+if not defined VULKAN_SDK set VULKAN_SDK=C:\VulkanSDK\1.4.335.0
+set GLSLC=%VULKAN_SDK%\Bin\glslc.exe
+if not exist "%GLSLC%" (
+    echo [ERROR] glslc not found at %GLSLC%. Install the Vulkan SDK or set VULKAN_SDK. 1>&2
+    exit /b 1
+)
+
+if not exist ..\data\shaders mkdir ..\data\shaders
 pushd shaders
-set VULKAN_SDK=C:/VulkanSDK/1.4.309.0
-for /r %%i in (*.frag, *.vert) do %VULKAN_SDK%/Bin/glslc %%i -o ../../data/shaders/%%~ni.spv
+for %%i in (*.frag *.vert *.comp) do (
+    "%GLSLC%" %%i -o ..\..\data\shaders\%%~ni.spv || (popd & exit /b 1)
+)
 popd
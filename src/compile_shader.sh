@@ -0,0 +1,21 @@
+#!/bin/bash
+
+
+# Stop at errors.
+set -e
+
+if ! command -v glslc > /dev/null; then
+    echo "[ERROR] glslc not found. Install the Vulkan SDK or shaderc so it's on PATH." >&2
+    exit 1
+fi
+
+CurDir=$(pwd)
+ShaderDir="$CurDir/../data/shaders"
+
+[ -d $ShaderDir ] || mkdir -p $ShaderDir
+
+pushd shaders > /dev/null
+for Shader in *.vert *.frag *.comp; do
+    glslc "$Shader" -o "$ShaderDir/${Shader%.*}.spv"
+done
+popd > /dev/null
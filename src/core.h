@@ -10,6 +10,7 @@
 // @TODO: Remove this.
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "types.h"
 
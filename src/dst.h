@@ -16,6 +16,9 @@ struct Pair {
     A a;
     B b;
 };
+#include "dst_arena.h"
+#include "dst_pool.h"
 #include "dst_dynamic_array.h"
 #include "dst_queue.h"
+#include "dst_hash.h"
 #include "dst_hash_table.h"
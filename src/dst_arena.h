@@ -0,0 +1,122 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+// @NOTE: Linear allocator over one reserved range of address space. Pages are
+// committed in ARENA_COMMIT_SIZE steps as the arena grows and stay committed
+// after a pop or reset, so a warm arena costs a pointer bump per push. Zero is
+// a valid empty arena; the range is reserved on the first push.
+// Pushes aren't zeroed unless asked for: memory handed out again after a pop or
+// reset holds whatever was there. Not thread-safe.
+// flags are Os_Memory_Flags for the range; set them before the first push. With a
+// huge page hint the arena commits whole huge pages at a time.
+#define ARENA_RESERVE_SIZE  ((umm)1 << 30)
+#define ARENA_COMMIT_SIZE   ((umm)64 << 10)
+
+struct Memory_Arena {
+    u8 *base;
+    umm reserved;
+    umm committed;
+    umm used;
+    u32 temp_count;
+    u32 flags;
+};
+
+struct Temp_Memory {
+    Memory_Arena *arena;
+    umm used;
+};
+
+function void *
+push_size(Memory_Arena *arena, umm size, umm alignment = 16) {
+    ASSERT((alignment & (alignment - 1)) == 0);
+    if (!arena->base) {
+        arena->reserved = ARENA_RESERVE_SIZE;
+        arena->base = (u8 *)os.reserve(arena->reserved, arena->flags);
+        ASSERT(arena->base);
+    }
+
+    umm offset = (arena->used + alignment - 1) & ~(alignment - 1);
+    umm new_used = offset + size;
+    ASSERT(new_used <= arena->reserved);
+    if (new_used > arena->committed) {
+        umm commit_size = (arena->flags & (OS_MEMORY_HUGE_PAGES|OS_MEMORY_HUGETLB)) ? OS_HUGE_PAGE_SIZE : ARENA_COMMIT_SIZE;
+        umm new_committed = (new_used + commit_size - 1) & ~(commit_size - 1);
+        new_committed = MIN(new_committed, arena->reserved);
+        b32 committed = os.commit(arena->base + arena->committed, new_committed - arena->committed, arena->flags);
+        ASSERT(committed);
+        arena->committed = new_committed;
+    }
+
+    arena->used = new_used;
+    void *result = arena->base + offset;
+    return result;
+}
+
+function void *
+push_size_zero(Memory_Arena *arena, umm size, umm alignment = 16) {
+    void *result = push_size(arena, size, alignment);
+    memset(result, 0, size);
+    return result;
+}
+
+#define push_struct(arena, T)               ((T *)push_size((arena), sizeof(T), alignof(T)))
+#define push_struct_zero(arena, T)          ((T *)push_size_zero((arena), sizeof(T), alignof(T)))
+#define push_array(arena, T, count)         ((T *)push_size((arena), sizeof(T)*(count), alignof(T)))
+#define push_array_zero(arena, T, count)    ((T *)push_size_zero((arena), sizeof(T)*(count), alignof(T)))
+
+// @NOTE: Gives back the last size bytes pushed (alignment padding stays used).
+function void
+pop_size(Memory_Arena *arena, umm size) {
+    ASSERT(size <= arena->used);
+    arena->used -= size;
+}
+
+// @NOTE: Everything pushed between begin and end is popped at end. Scopes nest;
+// end them in reverse order.
+function Temp_Memory
+begin_temp_memory(Memory_Arena *arena) {
+    Temp_Memory result;
+    result.arena = arena;
+    result.used  = arena->used;
+    ++arena->temp_count;
+    return result;
+}
+
+function void
+end_temp_memory(Temp_Memory temp) {
+    Memory_Arena *arena = temp.arena;
+    ASSERT(arena->used >= temp.used && arena->temp_count > 0);
+    arena->used = temp.used;
+    --arena->temp_count;
+}
+
+#define TEMP_MEMORY_SCOPE(arena) \
+    Temp_Memory STRING_JOIN2(temp_memory_, __LINE__) = begin_temp_memory(arena); \
+    SCOPE_EXIT(end_temp_memory(STRING_JOIN2(temp_memory_, __LINE__)))
+
+// @NOTE: Keeps the committed pages for the next round.
+function void
+arena_reset(Memory_Arena *arena) {
+    ASSERT(arena->temp_count == 0);
+    arena->used = 0;
+}
+
+function void
+arena_free(Memory_Arena *arena) {
+    if (arena->base) {
+        os.release(arena->base, arena->reserved);
+    }
+    u32 flags = arena->flags;
+    *arena = Memory_Arena{};
+    arena->flags = flags;
+}
@@ -8,42 +8,88 @@
 
    ======================================================================== */
 
+// @NOTE: Grows geometrically, so n pushes cost O(n) copies in total. Items are
+// moved with memcpy when T allows it. Memory from os.alloc is zeroed, but slots
+// handed out again after clear() hold whatever was there. memory_flags are
+// Os_Memory_Flags for the array's blocks, for arrays that get big and hot.
+#define DYNAMIC_ARRAY_MIN_SIZE 32
+
 template<typename T>
 struct Dynamic_Array {
     T *data;
     umm size;
     umm count;
+    u32 memory_flags;
 
+    // @NOTE: Discards the contents.
     void init(umm size_) {
         size = size_;
         os.free(data);
-        data = (T *)os.alloc(sizeof(T) * size);
+        data = (T *)os.alloc_hinted(sizeof(T) * size, memory_flags);
         count = 0;
     }
 
-    void push(T item) {
-        if (size == 0) {
-            size = 32;
-            data = (T *)os.alloc(sizeof(T) * size);
-            count = 0;
+    static void copy_items(T *src, T *dst, umm n) {
+        if constexpr (__is_trivially_copyable(T)) {
+            memcpy(dst, src, sizeof(T)*n);
         } else {
-            if (count == size) {
-                T *old = data;
-                size = size + 32;
-                data = (T *)os.alloc(sizeof(T) * size);
-                copy_array(old, data, count);
-                os.free(old);
+            for (umm i = 0; i < n; ++i) {
+                dst[i] = src[i];
             }
         }
+    }
+
+    // @NOTE: Keeps the contents.
+    void reserve(umm new_size) {
+        if (size < new_size) {
+            T *old = data;
+            data = (T *)os.alloc_hinted(sizeof(T) * new_size, memory_flags);
+            copy_items(old, data, count);
+            os.free(old);
+            size = new_size;
+        }
+    }
+
+    void grow(umm min_size) {
+        reserve(MAX(MAX(min_size, 2*size), (umm)DYNAMIC_ARRAY_MIN_SIZE));
+    }
+
+    void push(T item) {
+        if (count == size) {
+            grow(count + 1);
+        }
         data[count++] = item;
     }
 
+    // @NOTE: Returns the new slot for the caller to write in place.
+    T *emplace(void) {
+        if (count == size) {
+            grow(count + 1);
+        }
+        return data + count++;
+    }
+
+    // @NOTE: Returns the first of n new slots.
+    T *push_n(umm n) {
+        if (size < count + n) {
+            grow(count + n);
+        }
+        T *result = data + count;
+        count += n;
+        return result;
+    }
+
+    void append(T *items, umm n) {
+        copy_items(items, push_n(n), n);
+    }
+
     void clear(void) {
         count = 0;
     }
 
     void free(void) {
         os.free(data);
+        data = 0;
         size = 0;
         count = 0;
     }
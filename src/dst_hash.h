@@ -0,0 +1,153 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+// @NOTE: hash() for every key type returns all 64 bits mixed, so tables can mask
+// off a power of two (low bits) and still take a tag from the top bits.
+
+// @NOTE: Murmur3's fmix64 finalizer with the constants from splitmix64.
+// Bijective, so distinct keys never collide before masking.
+function u64
+hash_mix(u64 x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+function umm
+hash(u32 key) {
+    return hash_mix(key);
+}
+
+function umm
+hash(u64 key) {
+    return hash_mix(key);
+}
+
+// @NOTE: 64x64 -> 128 multiply, folded back to 64 by xoring the halves.
+function u64
+hash_mum(u64 a, u64 b) {
+#if _MSC_VER
+    u64 hi;
+    u64 lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#elif __GNUC__
+    __uint128_t product = (__uint128_t)a * b;
+    return (u64)product ^ (u64)(product >> 64);
+#endif
+}
+
+function u64
+hash_read_u64(u8 *p) {
+    u64 result;
+    memcpy(&result, p, 8);
+    return result;
+}
+
+function u64
+hash_read_u32(u8 *p) {
+    u32 result;
+    memcpy(&result, p, 4);
+    return result;
+}
+
+#define HASH_SECRET_0 0xA0761D6478BD642Full
+#define HASH_SECRET_1 0xE7037ED1A0B428DBull
+#define HASH_SECRET_2 0x8EBC6AF09C88C6E3ull
+#define HASH_SECRET_3 0x589965CC75374CC3ull
+
+// @NOTE: wyhash (final version 4): 48 bytes per step in three independent
+// multiply chains, then the tail with overlapping reads so there's no byte loop.
+// For paths, file contents and other blobs; not stable across versions of this
+// function, so don't write the results to disk.
+function u64
+hash_bytes(void *data, umm size, u64 seed = 0) {
+    u8 *p = (u8 *)data;
+    seed ^= hash_mum(seed ^ HASH_SECRET_0, HASH_SECRET_1);
+    u64 a, b;
+    if (size <= 16) {
+        if (size >= 4) {
+            umm mid = (size >> 3) << 2;
+            a = (hash_read_u32(p) << 32) | hash_read_u32(p + mid);
+            b = (hash_read_u32(p + size - 4) << 32) | hash_read_u32(p + size - 4 - mid);
+        } else if (size > 0) {
+            a = ((u64)p[0] << 16) | ((u64)p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        umm i = size;
+        if (i > 48) {
+            u64 seed1 = seed, seed2 = seed;
+            do {
+                seed  = hash_mum(hash_read_u64(p)      ^ HASH_SECRET_1, hash_read_u64(p + 8)  ^ seed);
+                seed1 = hash_mum(hash_read_u64(p + 16) ^ HASH_SECRET_2, hash_read_u64(p + 24) ^ seed1);
+                seed2 = hash_mum(hash_read_u64(p + 32) ^ HASH_SECRET_3, hash_read_u64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = hash_mum(hash_read_u64(p) ^ HASH_SECRET_1, hash_read_u64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hash_read_u64(p + i - 16);
+        b = hash_read_u64(p + i - 8);
+    }
+    a ^= HASH_SECRET_1;
+    b ^= seed;
+    // @NOTE: Full mum, both halves kept, before the final fold.
+#if _MSC_VER
+    u64 hi;
+    a = _umul128(a, b, &hi);
+    b = hi;
+#elif __GNUC__
+    __uint128_t product = (__uint128_t)a * b;
+    a = (u64)product;
+    b = (u64)(product >> 64);
+#endif
+    u64 result = hash_mum(a ^ HASH_SECRET_0 ^ size, b ^ HASH_SECRET_1);
+    return result;
+}
+
+function u64
+hash_string(const char *string) {
+    return hash_bytes((void *)string, cstring_length(string));
+}
+
+// @NOTE: FNV-1a, 64-bit, folded to 32. Slow next to hash_bytes, but it's
+// constexpr, so ASSET_ID("doggo.png") is a constant in the binary. The same
+// function runs at load time for names that come from files, so both agree.
+// The top bit is always set to keep asset ids clear of small hand-picked ones.
+constexpr u32
+asset_id(const char *name) {
+    u64 h = 0xCBF29CE484222325ull;
+    while (*name) {
+        h ^= (u8)*name++;
+        h *= 0x100000001B3ull;
+    }
+    return (u32)(h ^ (h >> 32)) | 0x80000000u;
+}
+
+template<u32 ID>
+struct Asset_Id_Constant {
+    static constexpr u32 value = ID;
+};
+
+// @NOTE: Forces compile-time evaluation; name has to be a literal.
+#define ASSET_ID(name) (Asset_Id_Constant<asset_id(name)>::value)
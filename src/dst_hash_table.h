@@ -13,84 +13,218 @@
 
 
 
-function umm
-hash(u32 key) {
-    return key;
-}
-
-template<typename K, typename V>
-struct Hash_Table_Node {
-    K key;
-    V value;
-    Hash_Table_Node *next;
-};
-
 template<typename V>
 struct Hash_Get_Result {
     b32 found;
     V value;
 };
 
+// @NOTE: Open addressing, Swiss-table style. Every slot has a control byte:
+// EMPTY, DELETED, or the top 7 bits of the key's hash. Lookups compare 16
+// control bytes at once with SSE2 and only touch the keys whose byte matches.
+// Probing goes group by group (triangular steps cover every group, since the
+// group count is a power of two) and stops at the first group with an EMPTY.
+// Load, tombstones included, stays under 7/8.
+//
+// K needs hash(K) and ==. Zero is an empty table; nothing is allocated until
+// the first insert.
+#define HASH_TABLE_GROUP_SIZE   16
+#define HASH_TABLE_EMPTY        0x80
+#define HASH_TABLE_DELETED      0xFE
+#define HASH_TABLE_NONE         ((umm)-1)
+
 template<typename K, typename V>
 struct Hash_Table {
-    Hash_Table_Node<K, V> *sentinels;
-    umm sentinel_count;
-
-    void init(umm sentinel_count_) {
-        sentinel_count = sentinel_count_;
-        sentinels = (Hash_Table_Node<K, V> *)os.alloc(sizeof(Hash_Table_Node<K, V>) * sentinel_count);
-        for (umm i = 0; i < sentinel_count; ++i) {
-            sentinels[i].next = sentinels + i;
+    u8 *controls;
+    Pair<K, V> *slots;
+    umm capacity;           // power of two, at least one group
+    umm count;
+    umm deleted_count;
+
+    // @NOTE: Low bits pick the group, top 7 the control byte; see dst_hash.h.
+    static u64 hash_of(K key) {
+        return (u64)hash(key);
+    }
+
+    static u8 control_of(u64 h) {
+        return (u8)(h >> 57);
+    }
+
+    static __m128i load_group(u8 *group_controls) {
+        return _mm_loadu_si128((__m128i *)group_controls);
+    }
+
+    void init(umm capacity_) {
+        free();
+        reserve(capacity_);
+    }
+
+    umm find(K key, u64 h) {
+        if (capacity == 0) {
+            return HASH_TABLE_NONE;
+        }
+
+        __m128i tag   = _mm_set1_epi8((char)control_of(h));
+        __m128i empty = _mm_set1_epi8((char)HASH_TABLE_EMPTY);
+        umm group_mask = capacity/HASH_TABLE_GROUP_SIZE - 1;
+        umm group = h & group_mask;
+        for (umm step = 1; ; ++step) {
+            umm first = group*HASH_TABLE_GROUP_SIZE;
+            __m128i group_controls = load_group(controls + first);
+            u32 matches = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group_controls, tag));
+            while (matches) {
+                umm index = first + find_least_significant_set_bit(matches);
+                if (slots[index].a == key) {
+                    return index;
+                }
+                matches &= matches - 1;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(group_controls, empty))) {
+                return HASH_TABLE_NONE;
+            }
+            group = (group + step) & group_mask;
         }
     }
 
-    Hash_Table_Node<K, V> *get_sentinel(K key) {
-        if (sentinel_count == 0) {
-            init(32);
+    // @NOTE: First EMPTY or DELETED slot on h's probe sequence; both have the high
+    // bit set, full slots don't.
+    umm find_free(u64 h) {
+        umm group_mask = capacity/HASH_TABLE_GROUP_SIZE - 1;
+        umm group = h & group_mask;
+        for (umm step = 1; ; ++step) {
+            umm first = group*HASH_TABLE_GROUP_SIZE;
+            u32 free_slots = (u32)_mm_movemask_epi8(load_group(controls + first));
+            if (free_slots) {
+                return first + find_least_significant_set_bit(free_slots);
+            }
+            group = (group + step) & group_mask;
         }
-        umm bucket = hash(key) % sentinel_count;
-        return sentinels + bucket;
     }
 
+    void rehash(umm new_capacity) {
+        ASSERT(new_capacity >= HASH_TABLE_GROUP_SIZE && (new_capacity & (new_capacity - 1)) == 0);
+        u8 *old_controls = controls;
+        Pair<K, V> *old_slots = slots;
+        umm old_capacity = capacity;
+
+        controls = (u8 *)os.alloc(new_capacity);
+        slots = (Pair<K, V> *)os.alloc(sizeof(Pair<K, V>)*new_capacity);
+        memset(controls, HASH_TABLE_EMPTY, new_capacity);
+        capacity = new_capacity;
+        deleted_count = 0;
+
+        for (umm i = 0; i < old_capacity; ++i) {
+            if (!(old_controls[i] & 0x80)) {
+                umm index = find_free(hash_of(old_slots[i].a));
+                controls[index] = old_controls[i];
+                slots[index] = old_slots[i];
+            }
+        }
+
+        os.free(old_controls);
+        os.free(old_slots);
+    }
+
+    // @NOTE: Room for item_count items without growing.
+    void reserve(umm item_count) {
+        umm new_capacity = HASH_TABLE_GROUP_SIZE;
+        while (new_capacity*7 < item_count*8) {
+            new_capacity *= 2;
+        }
+        if (new_capacity > capacity) {
+            rehash(new_capacity);
+        }
+    }
+
+    // @NOTE: Overwrites the value if key is already in.
     void insert(K key, V value) {
-        Hash_Table_Node<K, V> *sentinel = get_sentinel(key);
-        Hash_Table_Node<K, V> *node = sentinel->next;
-
-        while (1) {
-            if (node->next == sentinel) {
-                Hash_Table_Node<K, V> *new_node = (Hash_Table_Node<K, V> *)os.alloc(sizeof(Hash_Table_Node<K, V>));
-                new_node->key = key;
-                new_node->value = value;
-                new_node->next = sentinel;
-
-                node->next = new_node;
-                break;
+        u64 h = hash_of(key);
+        umm index = find(key, h);
+        if (index != HASH_TABLE_NONE) {
+            slots[index].b = value;
+            return;
+        }
+
+        if ((count + deleted_count + 1)*8 > capacity*7) {
+            // @NOTE: Mostly tombstones: same size, rehashing just clears them.
+            umm new_capacity = (capacity == 0) ? HASH_TABLE_GROUP_SIZE : capacity;
+            if ((count + 1)*16 > capacity*7) {
+                new_capacity *= 2;
             }
+            rehash(new_capacity);
+        }
+
+        index = find_free(h);
+        deleted_count -= (controls[index] == HASH_TABLE_DELETED);
+        controls[index] = control_of(h);
+        slots[index] = Pair<K, V>{key, value};
+        ++count;
+    }
+
+    // @NOTE: A group that still has an EMPTY ends every probe that reaches it, so
+    // its slots can go straight back to EMPTY; elsewhere they leave a tombstone.
+    b32 remove(K key) {
+        umm index = find(key, hash_of(key));
+        if (index == HASH_TABLE_NONE) {
+            return false;
+        }
 
-            node = node->next;
+        umm first = index & ~(umm)(HASH_TABLE_GROUP_SIZE - 1);
+        __m128i empty = _mm_set1_epi8((char)HASH_TABLE_EMPTY);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(load_group(controls + first), empty))) {
+            controls[index] = HASH_TABLE_EMPTY;
+        } else {
+            controls[index] = HASH_TABLE_DELETED;
+            ++deleted_count;
         }
+        --count;
+        return true;
     }
 
     Hash_Get_Result<V> get(K key) {
         Hash_Get_Result<V> result{};
+        umm index = find(key, hash_of(key));
+        if (index != HASH_TABLE_NONE) {
+            result.found = true;
+            result.value = slots[index].b;
+        }
+        return result;
+    }
 
-        Hash_Table_Node<K, V> *sentinel = get_sentinel(key);
-        Hash_Table_Node<K, V> *node = sentinel->next;
-
-        while (1) {
-            if (node == sentinel) {
-                break;
-            }
-
-            if (node->key == key) {
-                result.found = true;
-                result.value = node->value;
-                break;
+    // @NOTE: Walks the full slots:
+    //   umm cursor = 0;
+    //   while (Pair<K, V> *slot = table.next(&cursor)) {...}
+    // Removing the slot just returned is fine; inserting isn't.
+    Pair<K, V> *next(umm *cursor) {
+        while (*cursor < capacity) {
+            umm first = *cursor & ~(umm)(HASH_TABLE_GROUP_SIZE - 1);
+            u32 full = ~(u32)_mm_movemask_epi8(load_group(controls + first)) & 0xFFFF;
+            full &= 0xFFFF << (*cursor - first);
+            if (full) {
+                umm index = first + find_least_significant_set_bit(full);
+                *cursor = index + 1;
+                return slots + index;
             }
+            *cursor = first + HASH_TABLE_GROUP_SIZE;
+        }
+        return 0;
+    }
 
-            node = node->next;
+    void clear(void) {
+        if (capacity) {
+            memset(controls, HASH_TABLE_EMPTY, capacity);
         }
+        count = 0;
+        deleted_count = 0;
+    }
 
-        return result;
+    void free(void) {
+        os.free(controls);
+        os.free(slots);
+        controls = 0;
+        slots = 0;
+        capacity = 0;
+        count = 0;
+        deleted_count = 0;
     }
 };
@@ -0,0 +1,98 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+// @NOTE: Fixed-size allocator for T. Slabs of POOL_SLAB_SIZE come from os.alloc
+// and are carved up on demand; freed items go on an intrusive free list and are
+// handed out again first. Items come back zeroed, like os.alloc. Slabs are only
+// returned by free_all(). Zero is a valid empty pool. Not thread-safe.
+#define POOL_SLAB_SIZE ((umm)64 << 10)
+
+struct Pool_Stats {
+    u32 live;           // items allocated and not freed
+    u32 peak;           // most live at once
+    u32 slab_count;
+    umm slab_bytes;
+};
+
+struct Pool_Free_Item {
+    Pool_Free_Item *next;
+};
+
+struct Pool_Slab {
+    Pool_Slab *next;
+    umm size;
+};
+
+template<typename T>
+struct Pool {
+    // @NOTE: Room for the free-list link, aligned for T, slab header kept off
+    // the first item's cache line.
+    static constexpr umm item_align = MAX(alignof(T), alignof(Pool_Free_Item));
+    static constexpr umm item_size  = (MAX(sizeof(T), sizeof(Pool_Free_Item)) + item_align - 1) & ~(item_align - 1);
+    static constexpr umm slab_header_size = MAX((umm)64, item_align);
+
+    Pool_Free_Item *free_list;
+    Pool_Slab *slabs;
+    u8 *unused_at;      // rest of the newest slab, never handed out yet
+    u8 *unused_end;
+    Pool_Stats stats;
+
+    T *alloc(void) {
+        void *result;
+        if (free_list) {
+            result = free_list;
+            free_list = free_list->next;
+        } else {
+            if (unused_at + item_size > unused_end) {
+                umm slab_size = MAX(POOL_SLAB_SIZE, slab_header_size + item_size);
+                Pool_Slab *slab = (Pool_Slab *)os.alloc(slab_size);
+                slab->next = slabs;
+                slab->size = slab_size;
+                slabs = slab;
+                unused_at  = (u8 *)slab + slab_header_size;
+                unused_end = (u8 *)slab + slab_size;
+                ++stats.slab_count;
+                stats.slab_bytes += slab_size;
+            }
+            result = unused_at;
+            unused_at += item_size;
+        }
+        memset(result, 0, sizeof(T));
+
+        ++stats.live;
+        stats.peak = MAX(stats.peak, stats.live);
+        return (T *)result;
+    }
+
+    void free(T *item) {
+        if (item) {
+            Pool_Free_Item *free_item = (Pool_Free_Item *)item;
+            free_item->next = free_list;
+            free_list = free_item;
+            --stats.live;
+        }
+    }
+
+    // @NOTE: Frees every item at once and gives the slabs back to the Os.
+    void free_all(void) {
+        while (slabs) {
+            Pool_Slab *next = slabs->next;
+            os.free(slabs);
+            slabs = next;
+        }
+        free_list  = 0;
+        unused_at  = 0;
+        unused_end = 0;
+        stats = Pool_Stats{};
+    }
+};
@@ -11,45 +11,213 @@
 
 
 
-template<typename T>
-struct Queue {
-    T data[256];
-    size_t front;
-    size_t count;
+#define DST_CACHE_LINE_SIZE 64
+
+// @NOTE: Bounded, lock-free, one producer thread and one consumer thread.
+// CAPACITY is a power of two. Each side keeps a stale copy of the other's index
+// and only rereads the shared one when the copy says full or empty, so in the
+// steady state neither side touches the other's cache line.
+template<typename T, u32 CAPACITY>
+struct Spsc_Queue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity should be a power of two.");
+
+    alignas(DST_CACHE_LINE_SIZE) volatile u32 write;    // producer
+    u32 cached_read;
+    alignas(DST_CACHE_LINE_SIZE) volatile u32 read;     // consumer
+    u32 cached_write;
+    alignas(DST_CACHE_LINE_SIZE) T items[CAPACITY];
+
+    // @NOTE: False when full.
+    b32 push(T item) {
+        u32 w = write;
+        if (w - cached_read == CAPACITY) {
+            cached_read = atomic_load_acquire_u32(&read);
+            if (w - cached_read == CAPACITY) {
+                return false;
+            }
+        }
+        items[w & (CAPACITY - 1)] = item;
+        atomic_store_release_u32(&write, w + 1);
+        return true;
+    }
+
+    // @NOTE: False when empty.
+    b32 pop(T *item) {
+        u32 r = read;
+        if (r == cached_write) {
+            cached_write = atomic_load_acquire_u32(&write);
+            if (r == cached_write) {
+                return false;
+            }
+        }
+        *item = items[r & (CAPACITY - 1)];
+        atomic_store_release_u32(&read, r + 1);
+        return true;
+    }
+};
+
+// @NOTE: Bounded, lock-free, any number of producers and consumers (Vyukov).
+// Each cell's sequence says whose turn it is: a producer at pos wants pos, a
+// consumer wants pos + 1. A CAS on the shared position claims the cell, and the
+// release store of the next sequence hands it over. Sequences are stored minus
+// the cell's index so a zeroed queue is a valid empty one.
+template<typename T, u32 CAPACITY>
+struct Mpmc_Queue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity should be a power of two.");
+
+    struct Cell {
+        volatile u32 sequence;
+        T item;
+    };
+
+    alignas(DST_CACHE_LINE_SIZE) volatile u32 enqueue_pos;
+    alignas(DST_CACHE_LINE_SIZE) volatile u32 dequeue_pos;
+    alignas(DST_CACHE_LINE_SIZE) Cell cells[CAPACITY];
+
+    // @NOTE: False when full.
+    b32 push(T item) {
+        u32 pos = enqueue_pos;
+        Cell *cell;
+        for (;;) {
+            u32 index = pos & (CAPACITY - 1);
+            cell = cells + index;
+            s32 diff = (s32)(atomic_load_acquire_u32(&cell->sequence) + index - pos);
+            if (diff == 0) {
+                u32 seen = atomic_compare_exchange_u32(&enqueue_pos, pos + 1, pos);
+                if (seen == pos) {
+                    break;
+                }
+                pos = seen;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos;
+            }
+        }
+        cell->item = item;
+        atomic_store_release_u32(&cell->sequence, pos + 1 - (pos & (CAPACITY - 1)));
+        return true;
+    }
+
+    // @NOTE: False when empty.
+    b32 pop(T *item) {
+        u32 pos = dequeue_pos;
+        Cell *cell;
+        for (;;) {
+            u32 index = pos & (CAPACITY - 1);
+            cell = cells + index;
+            s32 diff = (s32)(atomic_load_acquire_u32(&cell->sequence) + index - (pos + 1));
+            if (diff == 0) {
+                u32 seen = atomic_compare_exchange_u32(&dequeue_pos, pos + 1, pos);
+                if (seen == pos) {
+                    break;
+                }
+                pos = seen;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos;
+            }
+        }
+        *item = cell->item;
+        atomic_store_release_u32(&cell->sequence, pos + CAPACITY - (pos & (CAPACITY - 1)));
+        return true;
+    }
 };
 
-template<typename T>
-T dequeue(Queue<T> *q) {
-    ASSERT(q->count > 0);
-
-    T result = q->data[q->front++];
-    q->front = (q->front) % arraycount(q->data);
-    --q->count;
-    return result;
-}
-
-template<typename T>
-void enqueue(Queue<T> *q, T item) {
-    ASSERT(q->count < arraycount(q->data));
-
-    size_t idx = ((q->front + q->count) % arraycount(q->data));
-    q->data[idx] = item;
-    ++q->count;
-}
-
-template<typename T>
-bool empty(Queue<T> *q) {
-    if (q->count == 0) return true;
-    return false;
-}
-
-template<typename T>
-void clear(Queue<T> *q) {
-    q->count = 0;
-}
-
-template<typename T>
-T peek(Queue<T> *q) {
-    ASSERT(q->count > 0);
-    return q->data[q->front];
-}
+// @NOTE: Unbounded, lock-free, one producer at a time and one consumer thread.
+// Several producer threads are fine if they serialize among themselves (the
+// renderer's image queues are only pushed under image_lock). Items live in
+// chunks of CHUNK_SIZE linked in order. The producer links a new chunk when the
+// last fills, and never touches a chunk again once it has moved on, so the
+// consumer frees each chunk as soon as it has read past it. Chunks come from a
+// pool the two sides share under chunk_lock, taken once per CHUNK_SIZE items.
+// A zeroed queue is a valid empty one.
+template<typename T, u32 CHUNK_SIZE = 256>
+struct Chunked_Queue {
+    struct Chunk {
+        Chunk *next;
+        T items[CHUNK_SIZE];
+    };
+
+    // @NOTE: The consumer only follows next or reads an item after seeing pushed
+    // (acquire) move past it, and the producer writes both before it moves pushed.
+    alignas(DST_CACHE_LINE_SIZE) Chunk *tail;           // producer
+    u32 tail_index;
+    volatile u32 pushed;
+    alignas(DST_CACHE_LINE_SIZE) Chunk *head;           // consumer
+    u32 head_index;
+    volatile u32 popped;
+    alignas(DST_CACHE_LINE_SIZE) volatile u32 chunk_lock;
+    Pool<Chunk> chunk_pool;
+
+    Chunk *alloc_chunk(void) {
+        spin_lock(&chunk_lock);
+        Chunk *result = chunk_pool.alloc();
+        spin_unlock(&chunk_lock);
+        return result;
+    }
+
+    void free_chunk(Chunk *chunk) {
+        spin_lock(&chunk_lock);
+        chunk_pool.free(chunk);
+        spin_unlock(&chunk_lock);
+    }
+
+    void push(T item) {
+        if (!tail) {
+            tail = head = alloc_chunk();
+        } else if (tail_index == CHUNK_SIZE) {
+            Chunk *chunk = alloc_chunk();
+            tail->next = chunk;
+            tail = chunk;
+            tail_index = 0;
+        }
+        tail->items[tail_index++] = item;
+        atomic_store_release_u32(&pushed, pushed + 1);
+    }
+
+    // @NOTE: False when empty.
+    b32 pop(T *item) {
+        if (popped == atomic_load_acquire_u32(&pushed)) {
+            return false;
+        }
+        if (head_index == CHUNK_SIZE) {
+            Chunk *next = head->next;
+            free_chunk(head);
+            head = next;
+            head_index = 0;
+        }
+        *item = head->items[head_index++];
+        atomic_store_release_u32(&popped, popped + 1);
+        return true;
+    }
+
+    // @NOTE: Consumer side. Items pushed and not yet popped; more may be on the way.
+    u32 count(void) {
+        return atomic_load_acquire_u32(&pushed) - popped;
+    }
+
+    // @NOTE: Consumer side. The index-th item not yet popped, without popping it;
+    // index has to be below count().
+    T *peek(u32 index) {
+        Chunk *chunk = head;
+        index += head_index;
+        while (index >= CHUNK_SIZE) {
+            chunk = chunk->next;
+            index -= CHUNK_SIZE;
+        }
+        return chunk->items + index;
+    }
+
+    // @NOTE: Nobody may be pushing or popping.
+    void free(void) {
+        chunk_pool.free_all();
+        head = 0;
+        tail = 0;
+        tail_index = 0;
+        head_index = 0;
+        pushed = 0;
+        popped = 0;
+    }
+};
@@ -74,3 +74,172 @@ round_f32_to_u32(f32 x) {
     s32 result = (u32)_mm_cvtss_si32(_mm_set_ss(x));
     return result;
 }
+
+// @NOTE: Undefined for 0.
+function u32
+find_least_significant_set_bit(u32 value) {
+#if _MSC_VER
+    unsigned long result;
+    _BitScanForward(&result, value);
+    return (u32)result;
+#elif __GNUC__
+    u32 result = (u32)__builtin_ctz(value);
+    return result;
+#endif
+}
+
+// @NOTE: Undefined for 0.
+function u32
+find_most_significant_set_bit(u32 value) {
+#if _MSC_VER
+    unsigned long result;
+    _BitScanReverse(&result, value);
+    return (u32)result;
+#elif __GNUC__
+    u32 result = 31 - (u32)__builtin_clz(value);
+    return result;
+#endif
+}
+
+// @NOTE: Full barriers on both compilers, except the acquire/release pair.
+// Read-modify-writes return the value before the operation.
+#if _MSC_VER
+function u32
+atomic_compare_exchange_u32(volatile u32 *value, u32 new_value, u32 expected) {
+    u32 result = (u32)_InterlockedCompareExchange((volatile long *)value, (long)new_value, (long)expected);
+    return result;
+}
+
+function u32
+atomic_add_u32(volatile u32 *value, u32 addend) {
+    u32 result = (u32)_InterlockedExchangeAdd((volatile long *)value, (long)addend);
+    return result;
+}
+
+function u64
+atomic_add_u64(volatile u64 *value, u64 addend) {
+    u64 result = (u64)_InterlockedExchangeAdd64((volatile __int64 *)value, (__int64)addend);
+    return result;
+}
+
+function void
+atomic_store_u32(volatile u32 *value, u32 new_value) {
+    _InterlockedExchange((volatile long *)value, (long)new_value);
+}
+
+// @NOTE: x86 loads and stores are already acquire and release; these only keep
+// the compiler from moving memory accesses across them.
+function u32
+atomic_load_acquire_u32(volatile u32 *value) {
+    u32 result = *value;
+    _ReadWriteBarrier();
+    return result;
+}
+
+function void
+atomic_store_release_u32(volatile u32 *value, u32 new_value) {
+    _ReadWriteBarrier();
+    *value = new_value;
+}
+#elif __GNUC__
+function u32
+atomic_compare_exchange_u32(volatile u32 *value, u32 new_value, u32 expected) {
+    u32 result = __sync_val_compare_and_swap(value, expected, new_value);
+    return result;
+}
+
+function u32
+atomic_add_u32(volatile u32 *value, u32 addend) {
+    u32 result = __sync_fetch_and_add(value, addend);
+    return result;
+}
+
+function u64
+atomic_add_u64(volatile u64 *value, u64 addend) {
+    u64 result = __sync_fetch_and_add(value, addend);
+    return result;
+}
+
+function void
+atomic_store_u32(volatile u32 *value, u32 new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_SEQ_CST);
+}
+
+function u32
+atomic_load_acquire_u32(volatile u32 *value) {
+    u32 result = __atomic_load_n(value, __ATOMIC_ACQUIRE);
+    return result;
+}
+
+function void
+atomic_store_release_u32(volatile u32 *value, u32 new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+#endif
+
+// @NOTE: Test-and-test-and-set, so waiters spin on a shared read instead of
+// bouncing the line with CAS.
+function void
+spin_lock(volatile u32 *lock) {
+    while (atomic_compare_exchange_u32(lock, 1, 0) != 0) {
+        while (*lock) {
+            _mm_pause();
+        }
+    }
+}
+
+function void
+spin_unlock(volatile u32 *lock) {
+    atomic_store_u32(lock, 0);
+}
+
+// @NOTE: For SIMD kernels picked at runtime. GCC only emits AVX2 in functions
+// marked with TARGET_AVX2; MSVC takes the intrinsics anywhere.
+#if _MSC_VER
+#  define TARGET_AVX2
+#elif __GNUC__
+#  define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+function void
+cpuid(u32 leaf, u32 subleaf, u32 out[4]) {
+#if _MSC_VER
+    __cpuidex((int *)out, (int)leaf, (int)subleaf);
+#elif __GNUC__
+    __asm__ __volatile__("cpuid" : "=a"(out[0]), "=b"(out[1]), "=c"(out[2]), "=d"(out[3]) : "a"(leaf), "c"(subleaf));
+#endif
+}
+
+function u64
+xgetbv(u32 index) {
+#if _MSC_VER
+    u64 result = _xgetbv(index);
+#elif __GNUC__
+    u32 lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(index));
+    u64 result = ((u64)hi << 32) | lo;
+#endif
+    return result;
+}
+
+// @NOTE: The CPU flag alone isn't enough; the OS also has to save ymm state
+// (OSXSAVE, then XCR0 bits 1 and 2).
+function b32
+cpu_has_avx2(void) {
+    u32 regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) {
+        return false;
+    }
+
+    cpuid(1, 0, regs);
+    b32 osxsave = (regs[2] >> 27) & 1;
+    b32 avx     = (regs[2] >> 28) & 1;
+    if (!osxsave || !avx || (xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    cpuid(7, 0, regs);
+    b32 result = (regs[1] >> 5) & 1;
+    return result;
+}
@@ -12,6 +12,7 @@
 
 
 #include <sys/mman.h>
+#include <pthread.h>
 #include <dlfcn.h>
 
 #include <unistd.h>
@@ -31,8 +32,12 @@ Os os;
 
 #include "dst.h"
 
+#include "renderer_atlas.h"
 #include "renderer.h"
+#include "renderer_capture.h"
+#include "renderer_hierarchy.h"
 #include "linux_renderer.h"
+#include "linux_memory.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "vendor/stb_image.h"
@@ -47,19 +52,6 @@ global b32 g_running = true;
 #endif
     
 
-// @SPEC: ZII
-function
-OS_ALLOC(linux_alloc) {
-    void *result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-    return result;
-}
-
-function
-OS_FREE(linux_free) {
-    if (memory) {
-        // @TODO:
-    }
-}
 
 function f32
 rand01(void) {
@@ -67,7 +59,7 @@ rand01(void) {
 }
 
 
-int main(void) {
+int main(int argc, char **argv) {
     Display *display = XOpenDisplay(NULL);
     if (!display) {
         INVALID_CODE_PATH;
@@ -98,17 +90,58 @@ int main(void) {
 
     g_renderer = renderer_function_table.load_renderer(display, window);
 
-    os.alloc = linux_alloc;
-    os.free  = linux_free;
+    os.alloc        = linux_alloc;
+    os.alloc_hinted = linux_alloc_hinted;
+    os.free         = linux_free;
+    os.alloc_stats  = linux_alloc_stats;
+    os.reserve      = linux_reserve;
+    os.commit       = linux_commit;
+    os.release      = linux_release;
+
+    // @NOTE: --capture <file> [frames] records frames for linux_replay.
+    for (int i = 1; i < argc; ++i) {
+        if (cstring_equal(argv[i], "--capture") && i + 1 < argc) {
+            u32 frame_count = (i + 2 < argc) ? (u32)atoi(argv[i + 2]) : 600;
+            renderer_begin_capture(argv[i + 1], frame_count);
+        }
+        // @NOTE: --gpu-cull draws quads as instanced sprites culled by the backend.
+        if (cstring_equal(argv[i], "--gpu-cull")) {
+            g_renderer->instanced_sprites = true;
+            g_renderer->gpu_cull_sprites  = true;
+        }
+    }
 
-    Image images[3];
-    images[0].id = 2;
+    Image images[3] = {};
+    images[0].id = ASSET_ID("texture.jpg");
     images[0].data = stbi_load("../data/texture.jpg", (int *)&images[0].width, (int *)&images[0].height, 0, 4);
-    images[1].id = 3;
+    images[1].id = ASSET_ID("doggo.png");
     images[1].data = stbi_load("../data/doggo.png", (int *)&images[1].width, (int *)&images[1].height, 0, 4);
-    images[2].id = 4;
+    images[2].id = ASSET_ID("doggo2.png");
     images[2].data = stbi_load("../data/doggo2.png", (int *)&images[2].width, (int *)&images[2].height, 0, 4);
 
+    // @NOTE: The background never changes, so it's built once and drawn by handle.
+    Static_Batch background = create_static_batch();
+    begin_static_batch(background);
+    for (u32 y = 0; y < 32; ++y) {
+        for (u32 x = 0; x < 32; ++x) {
+            v2 center = {64.0f*x + 32.0f, 64.0f*y + 32.0f};
+            draw_textured_quad(center, v2{64, 64}, images[(x + y) % arraycount(images)]);
+        }
+    }
+    end_static_batch();
+
+    // @NOTE: A sun with a planet and its moon; only the rotations change per frame.
+    Transform_Hierarchy hierarchy{};
+    Transform_Node sun = create_node(&hierarchy, Transform_Node{});
+    set_node_sprite(&hierarchy, sun, images[0], v2{96, 96}, v4{1,1,1,1});
+    Transform_Node planet = create_node(&hierarchy, sun);
+    set_node_trs(&hierarchy, planet, v2{160, 0}, 0.0f, v2{0.5f, 0.5f});
+    set_node_sprite(&hierarchy, planet, images[1], v2{96, 96}, v4{1,1,1,1});
+    Transform_Node moon = create_node(&hierarchy, planet);
+    set_node_trs(&hierarchy, moon, v2{120, 0}, 0.0f, v2{0.5f, 0.5f});
+    set_node_sprite(&hierarchy, moon, images[2], v2{96, 96}, v4{1,1,1,1});
+    f32 angle = 0.0f;
+
     while (g_running) {
         while (XPending(display)) {
             XEvent event{};
@@ -120,6 +153,12 @@ int main(void) {
         f32 w = (f32)attr.width;
         f32 h = (f32)attr.height;
 
+        set_view_rect(rect2_min_max(v2{0, 0}, v2{w, h}));
+
+        set_layer(0, false);
+        draw_static_batch(background);
+
+        set_layer(1, false);
         for (u32 i = 0; i < 256; ++i) {
             u32 max_image_index = arraycount(images) - 1;
             u32 image_index = (u32)(rand01()*max_image_index + 0.5f);
@@ -128,8 +167,35 @@ int main(void) {
             draw_textured_quad(center, dim, images[image_index]);
         }
 
-        renderer_bubblesort();
-        renderer_fill_drawcall_vertex_count();
+        // @NOTE: A panel and a diamond mask nested in it, with a row of quads running
+        // past both.
+        set_layer(2, false);
+        Rect2 panel = rect2_min_dim(v2{0.25f*w, 0.25f*h}, v2{0.5f*w, 0.5f*h});
+        push_clip_rect(panel);
+        for (u32 i = 0; i < 16; ++i) {
+            draw_textured_quad(v2{0.2f*w + (f32)i*0.04f*w, 0.3f*h}, v2{48, 48}, images[i % arraycount(images)]);
+        }
+        v2 c = 0.5f*(panel.min + panel.max);
+        v2 r = 0.4f*(panel.max - panel.min);
+        v2 diamond[6] = {
+            c + v2{0, -r.y}, c + v2{r.x, 0}, c + v2{0, r.y},
+            c + v2{0, -r.y}, c + v2{0, r.y}, c + v2{-r.x, 0},
+        };
+        push_clip_mask(diamond, 2);
+        for (u32 i = 0; i < 16; ++i) {
+            draw_textured_quad(v2{0.2f*w + (f32)i*0.04f*w, c.y}, v2{48, 48}, images[i % arraycount(images)]);
+        }
+        pop_clip();
+        pop_clip();
+
+        set_layer(3, false);
+        angle += 0.01f;
+        set_node_trs(&hierarchy, sun, v2{0.75f*w, 0.75f*h}, angle, v2{1, 1});
+        set_node_rotation(&hierarchy, planet, 3.0f*angle);
+        draw_hierarchy(&hierarchy);
+
+        renderer_sort();
+        renderer_fill_batches();
 
         renderer_function_table.end_frame();
     }
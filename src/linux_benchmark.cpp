@@ -0,0 +1,1767 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <pthread.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "core.h"
+#include "intrinsics.h"
+#include "math.h"
+
+#include "platform.h"
+
+Os os;
+
+#include "dst.h"
+
+#include "renderer_atlas.h"
+#include "renderer.h"
+#include "renderer_hierarchy.h"
+#include "linux_memory.h"
+
+global Renderer renderer;
+
+
+function f64
+linux_get_seconds(void) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    f64 result = (f64)ts.tv_sec + (f64)ts.tv_nsec*1e-9;
+    return result;
+}
+
+function f32
+rand01(void) {
+    return ((f32)rand() / RAND_MAX);
+}
+
+
+//
+// Sort
+//
+function void
+bench_fill_triangles(u32 triangle_count, u32 image_count) {
+    // @NOTE: Pre-size, so the timed runs don't include growth.
+    Draw_List *list = renderer.draw_lists;
+    if (list->sort_keys.size < triangle_count) {
+        list->sort_keys.init(triangle_count);
+        list->vertices.init(3*triangle_count);
+    }
+    renderer_clear_draw_list(list);
+    srand(1234);
+    for (u32 i = 0; i < triangle_count; ++i) {
+        u32 texture = 1 + (u32)(rand01()*(image_count - 1) + 0.5f);
+        v2 p = {rand01()*1920.0f, rand01()*1080.0f};
+        Vertex v = {p, v4{1,1,1,1}, v2{0,0}, texture};
+        set_layer(rand() % 4, (rand() % 4) == 0);
+        push_sort_key_and_triangle(make_sort_key(RENDERER_PIPELINE_SIMPLE, texture, true), v, v, v);
+    }
+}
+
+function b32
+bench_is_sorted(void) {
+    Dynamic_Array<Sort_Key> *keys = &renderer.draw_lists[0].sort_keys;
+    for (umm i = 1; i < keys->count; ++i) {
+        if (compare_sort_key(keys->data[i - 1], keys->data[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// @NOTE: The sort renderer_sort() replaced: swaps vertices on every compare and
+// goes quadratic with triangle count. Kept here as the baseline.
+function void
+bench_bubblesort(void) {
+    Draw_List *list = renderer.draw_lists;
+    umm length = list->sort_keys.count;
+    b32 terminate = (length < 2);
+    while (!terminate) {
+        terminate = true;
+        for (u32 i = 0; i < length - 1; ++i) {
+            u32 j = i + 1;
+            if (compare_sort_key(list->sort_keys.data[i], list->sort_keys.data[j])) {
+                Sort_Key ktmp = list->sort_keys.data[i];
+                list->sort_keys.data[i] = list->sort_keys.data[j];
+                list->sort_keys.data[j] = ktmp;
+
+                for (u32 k = 0; k < 3; ++k) {
+                    Vertex vtmp = list->vertices.data[3*i + k];
+                    list->vertices.data[3*i + k] = list->vertices.data[3*j + k];
+                    list->vertices.data[3*j + k] = vtmp;
+                }
+                terminate = false;
+            }
+        }
+    }
+}
+
+function void
+bench_sort(b32 full) {
+    printf("== sort (triangles, 16 textures, 4 layers, 1/4 translucent) ==\n");
+    printf("%10s %14s %14s\n", "triangles", "bubble ms", "radix ms");
+
+    u32 triangle_counts[] = {1000, 10000, 100000, 1000000};
+    for (u32 i = 0; i < arraycount(triangle_counts); ++i) {
+        u32 triangle_count = triangle_counts[i];
+
+        // @NOTE: Bubble sort is quadratic; 100k+ takes minutes, so only on request.
+        f64 bubble_ms = -1.0;
+        if (full || triangle_count <= 10000) {
+            bench_fill_triangles(triangle_count, 16);
+            f64 begin = linux_get_seconds();
+            bench_bubblesort();
+            bubble_ms = (linux_get_seconds() - begin)*1000.0;
+            ASSERT(bench_is_sorted());
+        }
+
+        // @NOTE: First run warms the scratch arrays, like every frame after the first.
+        f64 radix_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_fill_triangles(triangle_count, 16);
+            f64 begin = linux_get_seconds();
+            renderer_sort();
+            f64 ms = (linux_get_seconds() - begin)*1000.0;
+            if (run > 0) {
+                radix_ms = MIN(radix_ms, ms);
+            }
+            ASSERT(bench_is_sorted());
+        }
+
+        if (bubble_ms < 0.0) {
+            printf("%10u %14s %14.3f\n", triangle_count, "skipped", radix_ms);
+        } else {
+            printf("%10u %14.3f %14.3f\n", triangle_count, bubble_ms, radix_ms);
+        }
+    }
+}
+
+
+//
+// Quads
+//
+function void
+bench_clear_frame(void) {
+    for (u32 i = 0; i < RENDERER_DRAW_LIST_COUNT; ++i) {
+        renderer_clear_draw_list(renderer.draw_lists + i);
+    }
+    renderer.batches.clear();
+}
+
+enum Bench_Quad_Path {
+    BENCH_QUAD_PATH_FULL,
+    BENCH_QUAD_PATH_COMPACT,
+    BENCH_QUAD_PATH_INSTANCED,
+    BENCH_QUAD_PATH_COUNT,
+};
+
+function void
+bench_push_quad(Bench_Quad_Path path, v2 center, v2 dim, Image image) {
+    if (path == BENCH_QUAD_PATH_FULL) {
+        // @NOTE: Color past 1 (overbright) doesn't fit Vertex_Compact.
+        f32 w = 0.5f*dim.x;
+        f32 h = 0.5f*dim.y;
+        Vertex v[4];
+        v[0] = {center + v2{-w, h}, v4{2,2,2,1}, v2{0,1}, 0};
+        v[1] = {center + v2{ w, h}, v4{2,2,2,1}, v2{1,1}, 0};
+        v[2] = {center + v2{-w,-h}, v4{2,2,2,1}, v2{0,0}, 0};
+        v[3] = {center + v2{ w,-h}, v4{2,2,2,1}, v2{1,0}, 0};
+        draw_quad(v, image);
+    } else {
+        draw_textured_quad(center, dim, image);
+    }
+}
+
+function void
+bench_quads(void) {
+    u32 quad_count = 100000;
+    printf("== quads (%u, 16 textures) ==\n", quad_count);
+    printf("%10s %12s %12s %12s %14s %8s\n", "path", "push ms", "sort ms", "batch ms", "upload bytes", "batches");
+
+    // @NOTE: Pre-size, so the timed runs don't include growth.
+    Draw_List *list = renderer.draw_lists;
+    list->quad_sort_keys.init(quad_count);
+    list->quad_vertices.init(4*quad_count);
+    list->compact_quad_sort_keys.init(quad_count);
+    list->compact_quad_vertices.init(4*quad_count);
+    list->sprite_sort_keys.init(quad_count);
+    list->sprites.init(quad_count);
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 2 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+    }
+
+    const char *path_names[BENCH_QUAD_PATH_COUNT] = {"full", "compact", "instanced"};
+    for (u32 path = 0; path < BENCH_QUAD_PATH_COUNT; ++path) {
+        renderer.instanced_sprites = (path == BENCH_QUAD_PATH_INSTANCED);
+
+        f64 push_ms = F32_MAX;
+        f64 sort_ms = F32_MAX;
+        f64 batch_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+            srand(1234);
+
+            f64 begin = linux_get_seconds();
+            for (u32 i = 0; i < quad_count; ++i) {
+                v2 center = {rand01()*1920.0f, rand01()*1080.0f};
+                bench_push_quad((Bench_Quad_Path)path, center, v2{32,32}, images[i % arraycount(images)]);
+            }
+            f64 sorted = linux_get_seconds();
+            renderer_sort();
+            f64 batched = linux_get_seconds();
+            renderer_fill_batches();
+            f64 end = linux_get_seconds();
+
+            if (run > 0) {
+                push_ms  = MIN(push_ms,  (sorted - begin)*1000.0);
+                sort_ms  = MIN(sort_ms,  (batched - sorted)*1000.0);
+                batch_ms = MIN(batch_ms, (end - batched)*1000.0);
+            }
+        }
+
+        // @NOTE: The quad index buffer is static, so it isn't counted.
+        umm bytes = (list->quad_vertices.count*sizeof(Vertex) +
+                     list->compact_quad_vertices.count*sizeof(Vertex_Compact) +
+                     list->sprites.count*sizeof(Sprite_Instance));
+        printf("%10s %12.3f %12.3f %12.3f %14zu %8zu\n", path_names[path],
+               push_ms, sort_ms, batch_ms, (size_t)bytes, (size_t)renderer.batches.count);
+    }
+
+    renderer.instanced_sprites = false;
+    bench_clear_frame();
+}
+
+
+//
+// Batch quads (SoA)
+//
+function void
+bench_batch_quads(void) {
+    u32 quad_count = 200000;
+    printf("== batch quads (%u, 16 textures) ==\n", quad_count);
+    printf("%10s %12s %12s %16s\n", "path", "push ms", "quads/ms", "culled push ms");
+
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(quad_count);
+    list->compact_quad_vertices.init(4*quad_count);
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 2 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+    }
+
+    f32 *centers_x = (f32 *)os.alloc(sizeof(f32)*quad_count);
+    f32 *centers_y = (f32 *)os.alloc(sizeof(f32)*quad_count);
+    f32 *dims_x    = (f32 *)os.alloc(sizeof(f32)*quad_count);
+    f32 *dims_y    = (f32 *)os.alloc(sizeof(f32)*quad_count);
+    Image *quad_images = (Image *)os.alloc(sizeof(Image)*quad_count);
+    srand(1234);
+    for (u32 i = 0; i < quad_count; ++i) {
+        centers_x[i]   = rand01()*1920.0f;
+        centers_y[i]   = rand01()*1080.0f;
+        dims_x[i]      = 16.0f + rand01()*32.0f;
+        dims_y[i]      = 16.0f + rand01()*32.0f;
+        quad_images[i] = images[(i / 64) % arraycount(images)];
+    }
+
+    // @NOTE: Every batch kernel has to write the same bytes as the scalar one.
+    Vertex_Compact *reference = (Vertex_Compact *)os.alloc(sizeof(Vertex_Compact)*4*quad_count);
+    umm reference_count = 0;
+
+    // @NOTE: Path 0 is a draw_textured_quad() per quad, the rest are
+    // draw_textured_quads() with the kernel forced.
+    const char *path_names[] = {"per-call", "scalar", "sse2", "avx2"};
+    Renderer_Simd simds[]    = {RENDERER_SIMD_DETECT, RENDERER_SIMD_SCALAR, RENDERER_SIMD_SSE2, RENDERER_SIMD_AVX2};
+    for (u32 path = 0; path < arraycount(path_names); ++path) {
+        if (simds[path] == RENDERER_SIMD_AVX2 && !cpu_has_avx2()) {
+            printf("%10s %12s\n", path_names[path], "n/a");
+            continue;
+        }
+        renderer.simd = simds[path];
+
+        f64 push_ms[2] = {F32_MAX, F32_MAX};
+        for (u32 culled = 0; culled < 2; ++culled) {
+            if (culled) {
+                // Left half of the screen.
+                set_view_rect(rect2_min_max(v2{0, 0}, v2{960, 1080}));
+            }
+            for (u32 run = 0; run < 10; ++run) {
+                bench_clear_frame();
+
+                f64 begin = linux_get_seconds();
+                if (path == 0) {
+                    for (u32 i = 0; i < quad_count; ++i) {
+                        draw_textured_quad(v2{centers_x[i], centers_y[i]}, v2{dims_x[i], dims_y[i]}, quad_images[i]);
+                    }
+                } else {
+                    draw_textured_quads(quad_count, centers_x, centers_y, dims_x, dims_y, quad_images);
+                }
+                f64 end = linux_get_seconds();
+
+                if (run > 0) {
+                    push_ms[culled] = MIN(push_ms[culled], (end - begin)*1000.0);
+                }
+            }
+            clear_view_rect();
+        }
+
+        umm count = list->compact_quad_vertices.count;
+        if (path == 1) {
+            copy_array(list->compact_quad_vertices.data, reference, count);
+            reference_count = count;
+        } else if (path > 1) {
+            ASSERT(count == reference_count);
+            ASSERT(memcmp(reference, list->compact_quad_vertices.data, sizeof(Vertex_Compact)*count) == 0);
+        }
+
+        printf("%10s %12.3f %12.0f %16.3f\n", path_names[path], push_ms[0], quad_count / push_ms[0], push_ms[1]);
+    }
+
+    renderer.simd = RENDERER_SIMD_DETECT;
+    bench_clear_frame();
+}
+
+//
+// Opaque / translucent passes
+//
+function void
+bench_opacity(void) {
+    u32 quad_count = 100000;
+    printf("== opacity (%u quads, 4 layers, half the images opaque) ==\n", quad_count);
+    printf("%12s %12s %12s %12s\n", "push ms", "opaque", "translucent", "batches");
+
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(quad_count);
+    list->compact_quad_vertices.init(4*quad_count);
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 100 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+        images[i].alpha  = (i & 1) ? IMAGE_ALPHA_TRANSLUCENT : IMAGE_ALPHA_OPAQUE;
+    }
+
+    f64 push_ms = F32_MAX;
+    u32 opaque_count = 0;
+    for (u32 run = 0; run < 5; ++run) {
+        bench_clear_frame();
+        srand(1234);
+
+        f64 begin = linux_get_seconds();
+        for (u32 i = 0; i < quad_count; ++i) {
+            v2 center = {rand01()*1920.0f, rand01()*1080.0f};
+            set_layer(rand() % 4, false);
+            draw_textured_quad(center, v2{32,32}, images[rand() % arraycount(images)]);
+        }
+        f64 end = linux_get_seconds();
+        renderer_sort();
+        renderer_fill_batches();
+        if (run > 0) {
+            push_ms = MIN(push_ms, (end - begin)*1000.0);
+        }
+
+        // Opaque batches first, top layer down; then translucent, bottom layer up.
+        opaque_count = 0;
+        for (u32 i = 0; i < list->compact_quad_sort_keys.count; ++i) {
+            opaque_count += !list->compact_quad_sort_keys.data[i].translucent;
+        }
+        for (u32 i = 1; i < renderer.batches.count; ++i) {
+            Sort_Key a = renderer.batches.data[i - 1].sort_key;
+            Sort_Key b = renderer.batches.data[i].sort_key;
+            ASSERT(a.translucent <= b.translucent);
+            ASSERT(a.translucent != b.translucent || (a.translucent ? a.layer <= b.layer : a.layer >= b.layer));
+        }
+    }
+
+    printf("%12.3f %12u %12u %12zu\n", push_ms, opaque_count, quad_count - opaque_count, (size_t)renderer.batches.count);
+    bench_clear_frame();
+}
+
+
+//
+// Clips
+//
+function void
+bench_clips(void) {
+    u32 panel_count = 64;
+    u32 quads_per_panel = 1000;
+    printf("== clips (%u panels of %u quads, spread over 1.5x the panel) ==\n", panel_count, quads_per_panel);
+    printf("%10s %12s %10s %10s %10s\n", "path", "push ms", "drawn", "culled", "batches");
+
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(panel_count*quads_per_panel);
+    list->compact_quad_vertices.init(4*panel_count*quads_per_panel);
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 200 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+        images[i].alpha  = IMAGE_ALPHA_OPAQUE;
+    }
+
+    // @NOTE: Path 0 is unclipped, for the batch count without clips.
+    const char *path_names[] = {"no clip", "clip"};
+    for (u32 path = 0; path < arraycount(path_names); ++path) {
+        f64 push_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+            renderer_clear_clips();
+            srand(1234);
+
+            f64 begin = linux_get_seconds();
+            for (u32 panel = 0; panel < panel_count; ++panel) {
+                v2 panel_min = v2{(f32)(panel % 8)*240.0f, (f32)(panel / 8)*135.0f};
+                v2 panel_dim = v2{200.0f, 100.0f};
+                if (path == 1) {
+                    push_clip_rect(rect2_min_dim(panel_min, panel_dim));
+                }
+                for (u32 i = 0; i < quads_per_panel; ++i) {
+                    // Spread over 1.5x the panel, so about half lands outside it.
+                    v2 p = v2{(rand01()*1.5f - 0.25f)*panel_dim.x, (rand01()*1.5f - 0.25f)*panel_dim.y};
+                    draw_textured_quad(panel_min + p, v2{8, 8}, images[rand() % arraycount(images)]);
+                }
+                if (path == 1) {
+                    pop_clip();
+                }
+            }
+            f64 end = linux_get_seconds();
+            renderer_sort();
+            renderer_fill_batches();
+            if (run > 0) {
+                push_ms = MIN(push_ms, (end - begin)*1000.0);
+            }
+        }
+
+        // @NOTE: Draws sharing a clip stay one batch; every panel is one.
+        if (path == 1) {
+            ASSERT(renderer.batches.count == panel_count);
+        }
+        Renderer_Cull_Stats stats = renderer_get_cull_stats();
+        printf("%10s %12.3f %10zu %10u %10zu\n", path_names[path], push_ms,
+               (size_t)list->compact_quad_sort_keys.count, stats.culled, (size_t)renderer.batches.count);
+    }
+
+    bench_clear_frame();
+    renderer_clear_clips();
+}
+
+//
+// Hierarchy
+//
+function void
+bench_hierarchy(void) {
+    u32 root_count = 1000;
+    u32 fanout = 3;
+    u32 nodes_per_root = 1 + fanout + fanout*fanout;
+    u32 node_count = root_count*nodes_per_root;
+    printf("== hierarchy (%u roots, 2 levels of %u children, %u nodes) ==\n", root_count, fanout, node_count);
+    printf("%16s %12s %12s\n", "moving", "update ms", "draw ms");
+
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(node_count);
+    list->compact_quad_vertices.init(4*node_count);
+
+    Image image{};
+    image.id     = 300;
+    image.width  = 64;
+    image.height = 64;
+    image.alpha  = IMAGE_ALPHA_OPAQUE;
+
+    Transform_Hierarchy h{};
+    Transform_Node *roots = (Transform_Node *)os.alloc(sizeof(Transform_Node)*root_count);
+    srand(1234);
+    for (u32 r = 0; r < root_count; ++r) {
+        roots[r] = create_node(&h, Transform_Node{});
+        set_node_trs(&h, roots[r], v2{rand01()*1920.0f, rand01()*1080.0f}, rand01()*2.0f*pi32, v2{1, 1});
+        set_node_sprite(&h, roots[r], image, v2{16, 16}, v4{1,1,1,1});
+        for (u32 c = 0; c < fanout; ++c) {
+            Transform_Node child = create_node(&h, roots[r]);
+            set_node_trs(&h, child, v2{20, 0}, (f32)c*2.0f, v2{0.75f, 0.75f});
+            set_node_sprite(&h, child, image, v2{16, 16}, v4{1,1,1,1});
+            for (u32 g = 0; g < fanout; ++g) {
+                Transform_Node grandchild = create_node(&h, child);
+                set_node_trs(&h, grandchild, v2{12, 0}, (f32)g*2.0f, v2{0.5f, 0.5f});
+                set_node_sprite(&h, grandchild, image, v2{16, 16}, v4{1,1,1,1});
+            }
+        }
+    }
+    update_hierarchy(&h);
+
+    // @NOTE: Baseline recomputes every local and world transform every frame, the
+    // way a hierarchy without dirty flags would.
+    f64 full_ms = F32_MAX;
+    f64 full_draw_ms = F32_MAX;
+    Node_Quad full_quad{};
+    for (u32 run = 0; run < 5; ++run) {
+        bench_clear_frame();
+        f64 begin = linux_get_seconds();
+        for (u32 i = 0; i < node_count; ++i) {
+            v2 t = h.translations.data[i];
+            v2 s = h.scales.data[i];
+            h.locals.data[i] = trs_to_transform(v3{t.x, t.y, 0.0f},
+                                                build_quaternion(v3{0, 0, 1}, h.rotations.data[i]),
+                                                v3{s.x, s.y, 1.0f});
+            u32 parent = h.parents.data[i];
+            h.worlds.data[i] = (parent == HIERARCHY_NONE) ? h.locals.data[i] : h.worlds.data[parent]*h.locals.data[i];
+            hierarchy_build_quad(h.quads.data + i, h.worlds.data + i, h.sprites.data[i].dim);
+        }
+        f64 mid = linux_get_seconds();
+        draw_hierarchy(&h);
+        f64 end = linux_get_seconds();
+        full_quad = h.quads.data[node_count - 1];
+        if (run > 0) {
+            full_ms = MIN(full_ms, (mid - begin)*1000.0);
+            full_draw_ms = MIN(full_draw_ms, (end - mid)*1000.0);
+        }
+    }
+    printf("%16s %12.3f %12.3f\n", "all, no flags", full_ms, full_draw_ms);
+
+    // @NOTE: Dirty-only must land on the same corners as the full recompute.
+    ASSERT(memcmp(&full_quad, h.quads.data + node_count - 1, sizeof(Node_Quad)) == 0);
+
+    u32 moving_counts[] = {root_count, root_count / 10, 0};
+    const char *moving_names[] = {"all roots", "10% of roots", "none"};
+    for (u32 path = 0; path < arraycount(moving_counts); ++path) {
+        f64 update_ms = F32_MAX;
+        f64 draw_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+            f64 begin = linux_get_seconds();
+            for (u32 r = 0; r < moving_counts[path]; ++r) {
+                set_node_rotation(&h, roots[r], 0.01f*(f32)run);
+            }
+            update_hierarchy(&h);
+            f64 mid = linux_get_seconds();
+            draw_hierarchy(&h);
+            f64 end = linux_get_seconds();
+            ASSERT(list->compact_quad_sort_keys.count == node_count);
+            if (run > 0) {
+                update_ms = MIN(update_ms, (mid - begin)*1000.0);
+                draw_ms = MIN(draw_ms, (end - mid)*1000.0);
+            }
+        }
+        printf("%16s %12.3f %12.3f\n", moving_names[path], update_ms, draw_ms);
+    }
+
+    // @NOTE: Reparenting a root under a later one, and destroying another, forces a
+    // re-sort; the arrays must still be in pre-order and the destroyed subtree gone.
+    set_node_parent(&h, roots[0], roots[root_count - 1]);
+    destroy_node(&h, roots[1]);
+    f64 begin = linux_get_seconds();
+    update_hierarchy(&h);
+    f64 sort_ms = (linux_get_seconds() - begin)*1000.0;
+    ASSERT(h.parents.count == node_count - nodes_per_root);
+    for (u32 i = 1; i < h.parents.count; ++i) {
+        // @NOTE: A node's parent is the node before it or one of that node's ancestors.
+        u32 at = i - 1;
+        while (at != HIERARCHY_NONE && at != h.parents.data[i]) {
+            at = h.parents.data[at];
+        }
+        ASSERT(h.parents.data[i] == HIERARCHY_NONE || at != HIERARCHY_NONE);
+    }
+    printf("%16s %12.3f\n", "re-sort", sort_ms);
+
+    bench_clear_frame();
+}
+
+//
+// Culling
+//
+function void
+bench_culling(void) {
+    u32 quad_count = 100000;
+    printf("== culling (%u quads over 4x4 screens, view is one screen) ==\n", quad_count);
+    printf("%10s %12s %12s %10s %10s %14s\n", "path", "push ms", "sort ms", "tested", "culled", "upload bytes");
+
+    // @NOTE: Pre-size, so the timed runs don't include growth.
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(quad_count);
+    list->compact_quad_vertices.init(4*quad_count);
+    list->sprite_sort_keys.init(quad_count);
+    list->sprites.init(quad_count);
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 2 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+    }
+
+    // @NOTE: The sprite paths go through the instanced stream. "gpu cull" only
+    // measures the push side: every sprite is kept and uploaded, and the backend's
+    // compute pass would cull them, which can't run here.
+    const char *path_names[] = {"no view", "view", "camera", "sprites", "gpu cull"};
+    for (u32 path = 0; path < arraycount(path_names); ++path) {
+        clear_view_rect();
+        clear_camera();
+        renderer.instanced_sprites  = (path >= 3);
+        renderer.gpu_cull_sprites   = (path == 4);
+        renderer.gpu_cull_supported = (path == 4);
+        if (path >= 1) {
+            set_view_rect(rect2_min_max(v2{0, 0}, v2{1920, 1080}));
+        }
+        if (path == 2) {
+            // @NOTE: Zoomed out 2x and turned, so the cull rect is about 4x the view's area.
+            set_camera(v2{1920, 1080}, 0.3f, 0.5f);
+        }
+
+        f64 push_ms = F32_MAX;
+        f64 sort_ms = F32_MAX;
+        Renderer_Cull_Stats stats{};
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+            srand(1234);
+
+            f64 begin = linux_get_seconds();
+            for (u32 i = 0; i < quad_count; ++i) {
+                v2 center = {rand01()*4.0f*1920.0f, rand01()*4.0f*1080.0f};
+                draw_textured_quad(center, v2{32,32}, images[i % arraycount(images)]);
+            }
+            stats = renderer_get_cull_stats();
+            f64 pushed = linux_get_seconds();
+            renderer_sort();
+            renderer_fill_batches();
+            f64 end = linux_get_seconds();
+
+            if (run > 0) {
+                push_ms = MIN(push_ms, (pushed - begin)*1000.0);
+                sort_ms = MIN(sort_ms, (end - pushed)*1000.0);
+            }
+        }
+
+        umm bytes = (list->compact_quad_vertices.count*sizeof(Vertex_Compact) +
+                     list->sprites.count*sizeof(Sprite_Instance));
+        printf("%10s %12.3f %12.3f %10u %10u %14zu\n", path_names[path], push_ms, sort_ms,
+               stats.tested, stats.culled, (size_t)bytes);
+    }
+
+    renderer.instanced_sprites  = false;
+    renderer.gpu_cull_sprites   = false;
+    renderer.gpu_cull_supported = false;
+    clear_view_rect();
+    clear_camera();
+    bench_clear_frame();
+}
+
+
+//
+// Static batches
+//
+function void
+bench_push_background(u32 quad_count, Image *images, u32 image_count) {
+    for (u32 i = 0; i < quad_count; ++i) {
+        v2 center = {(f32)(32*(i % 320)), (f32)(32*(i / 320))};
+        draw_textured_quad(center, v2{32,32}, images[i % image_count]);
+    }
+}
+
+function void
+bench_static_batches(void) {
+    u32 background_count = 100000;
+    u32 dynamic_count = 1000;
+    printf("== static batches (%u background + %u dynamic quads) ==\n", background_count, dynamic_count);
+    printf("%10s %12s %14s %8s\n", "path", "frame ms", "upload bytes", "batches");
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 2 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+    }
+
+    // @NOTE: Pre-size, so the timed runs don't include growth.
+    Draw_List *list = renderer.draw_lists;
+    list->compact_quad_sort_keys.init(background_count + dynamic_count);
+    list->compact_quad_vertices.init(4*(background_count + dynamic_count));
+
+    Static_Batch background = create_static_batch();
+    renderer_get_static_batch(background)->vertices.init(4*background_count);
+    begin_static_batch(background);
+    bench_push_background(background_count, images, arraycount(images));
+    end_static_batch();
+
+    const char *path_names[] = {"immediate", "retained"};
+    for (u32 path = 0; path < arraycount(path_names); ++path) {
+        b32 retained = (path == 1);
+
+        f64 frame_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+            srand(1234);
+
+            f64 begin = linux_get_seconds();
+            set_layer(0, false);
+            if (retained) {
+                draw_static_batch(background);
+            } else {
+                bench_push_background(background_count, images, arraycount(images));
+            }
+            set_layer(1, false);
+            for (u32 i = 0; i < dynamic_count; ++i) {
+                v2 center = {rand01()*1920.0f, rand01()*1080.0f};
+                draw_textured_quad(center, v2{32,32}, images[i % arraycount(images)]);
+            }
+            renderer_sort();
+            renderer_fill_batches();
+            f64 end = linux_get_seconds();
+
+            if (run > 0) {
+                frame_ms = MIN(frame_ms, (end - begin)*1000.0);
+            }
+        }
+
+        // @NOTE: The static batch uploads once, not per frame, so it isn't counted.
+        umm bytes = (list->quad_vertices.count*sizeof(Vertex) +
+                     list->compact_quad_vertices.count*sizeof(Vertex_Compact) +
+                     list->sprites.count*sizeof(Sprite_Instance));
+        printf("%10s %12.3f %14zu %8zu\n", path_names[path], frame_ms, (size_t)bytes, (size_t)renderer.batches.count);
+    }
+
+    destroy_static_batch(background);
+    bench_clear_frame();
+}
+
+
+//
+// Threaded push
+//
+#define BENCH_THREAD_COUNT 8
+
+struct Bench_Push_Job {
+    u32 list_index;
+    u32 quad_count;
+    Image *images;
+    u32 image_count;
+};
+
+function void *
+bench_push_thread(void *param) {
+    Bench_Push_Job *job = (Bench_Push_Job *)param;
+    renderer_begin_draw_list(job->list_index);
+    u32 seed = 1234 + job->list_index;
+    for (u32 i = 0; i < job->quad_count; ++i) {
+        seed = seed*1664525 + 1013904223;
+        v2 center = {(f32)(seed & 0x7FF), (f32)((seed >> 11) & 0x3FF)};
+        set_layer(i & 3, false);
+        draw_textured_quad(center, v2{32,32}, job->images[i % job->image_count]);
+    }
+    renderer_end_draw_list();
+    return 0;
+}
+
+function void
+bench_threaded_push(void) {
+    u32 quad_count = 800000;
+    printf("== threaded push (%u quads, 16 textures) ==\n", quad_count);
+    printf("%10s %12s %12s %12s\n", "threads", "push ms", "merge+sort", "batches");
+
+    // @NOTE: Pre-size every list; a growing push maps fresh pages, and mmap
+    // serializes the threads on the kernel's mm lock.
+    for (u32 i = 0; i < BENCH_THREAD_COUNT; ++i) {
+        Draw_List *list = renderer.draw_lists + i;
+        list->compact_quad_sort_keys.init(quad_count);
+        list->compact_quad_vertices.init(4*quad_count);
+    }
+
+    Image images[16] = {};
+    for (u32 i = 0; i < arraycount(images); ++i) {
+        images[i].id = 2 + i;
+        images[i].width  = 64;
+        images[i].height = 64;
+    }
+
+    u32 thread_counts[] = {1, BENCH_THREAD_COUNT};
+    for (u32 t = 0; t < arraycount(thread_counts); ++t) {
+        u32 thread_count = thread_counts[t];
+
+        f64 push_ms = F32_MAX;
+        f64 sort_ms = F32_MAX;
+        for (u32 run = 0; run < 5; ++run) {
+            bench_clear_frame();
+
+            Bench_Push_Job jobs[BENCH_THREAD_COUNT];
+            pthread_t threads[BENCH_THREAD_COUNT];
+            f64 begin = linux_get_seconds();
+            for (u32 i = 0; i < thread_count; ++i) {
+                jobs[i] = {i, quad_count / thread_count, images, arraycount(images)};
+                pthread_create(threads + i, 0, bench_push_thread, jobs + i);
+            }
+            for (u32 i = 0; i < thread_count; ++i) {
+                pthread_join(threads[i], 0);
+            }
+            f64 pushed = linux_get_seconds();
+            renderer_sort();
+            f64 end = linux_get_seconds();
+            renderer_fill_batches();
+
+            ASSERT(renderer.draw_lists[0].compact_quad_sort_keys.count == quad_count);
+            if (run > 0) {
+                push_ms = MIN(push_ms, (pushed - begin)*1000.0);
+                sort_ms = MIN(sort_ms, (end - pushed)*1000.0);
+            }
+        }
+
+        printf("%10u %12.3f %12.3f %12zu\n", thread_count, push_ms, sort_ms, (size_t)renderer.batches.count);
+    }
+
+    bench_clear_frame();
+}
+
+
+//
+// Dynamic array
+//
+global u32 bench_alloc_count;
+
+function
+OS_ALLOC(bench_counting_alloc) {
+    ++bench_alloc_count;
+    return linux_alloc(size);
+}
+
+// @NOTE: What Dynamic_Array::push used to do: +32 items per growth, byte copy.
+function void
+bench_push_fixed_step(Dynamic_Array<Vertex> *array, Vertex item) {
+    if (array->count == array->size) {
+        Vertex *old = array->data;
+        array->size += 32;
+        array->data = (Vertex *)os.alloc(sizeof(Vertex)*array->size);
+        copy_array(old, array->data, array->count);
+        os.free(old);
+    }
+    array->data[array->count++] = item;
+}
+
+enum Bench_Array_Path {
+    BENCH_ARRAY_FIXED_STEP,
+    BENCH_ARRAY_PUSH,
+    BENCH_ARRAY_RESERVE_PUSH,
+    BENCH_ARRAY_EMPLACE,
+    BENCH_ARRAY_PUSH_N,
+    BENCH_ARRAY_APPEND,
+
+    BENCH_ARRAY_PATH_COUNT
+};
+
+function void
+bench_dynamic_array(void) {
+    u32 counts[] = {1000, 10000, 100000, 1000000};
+    printf("== dynamic array (Vertex, %zu bytes) ==\n", sizeof(Vertex));
+    printf("%10s %12s %12s %10s\n", "items", "path", "ms", "allocs");
+
+    const char *path_names[BENCH_ARRAY_PATH_COUNT] = {"fixed step", "push", "reserve", "emplace", "push_n", "append"};
+    Os_Alloc *alloc = os.alloc;
+    os.alloc = bench_counting_alloc;
+
+    for (u32 c = 0; c < arraycount(counts); ++c) {
+        u32 count = counts[c];
+        Dynamic_Array<Vertex> source{};
+        source.reserve(count);
+        for (u32 i = 0; i < count; ++i) {
+            source.push(Vertex{v2{(f32)i, (f32)i}, v4{1,1,1,1}, v2{0,0}, i & 15});
+        }
+
+        for (u32 path = 0; path < BENCH_ARRAY_PATH_COUNT; ++path) {
+            // @NOTE: The +32 step copies O(n^2) bytes; 100k already takes seconds a run.
+            if (path == BENCH_ARRAY_FIXED_STEP && count > 10000) {
+                continue;
+            }
+
+            f64 best_ms = F32_MAX;
+            u32 allocs = 0;
+            for (u32 run = 0; run < 5; ++run) {
+                Dynamic_Array<Vertex> array{};
+                bench_alloc_count = 0;
+
+                f64 begin = linux_get_seconds();
+                switch (path) {
+                    case BENCH_ARRAY_FIXED_STEP: {
+                        for (u32 i = 0; i < count; ++i) {
+                            bench_push_fixed_step(&array, source.data[i]);
+                        }
+                    } break;
+
+                    case BENCH_ARRAY_PUSH: {
+                        for (u32 i = 0; i < count; ++i) {
+                            array.push(source.data[i]);
+                        }
+                    } break;
+
+                    case BENCH_ARRAY_RESERVE_PUSH: {
+                        array.reserve(count);
+                        for (u32 i = 0; i < count; ++i) {
+                            array.push(source.data[i]);
+                        }
+                    } break;
+
+                    case BENCH_ARRAY_EMPLACE: {
+                        for (u32 i = 0; i < count; ++i) {
+                            *array.emplace() = source.data[i];
+                        }
+                    } break;
+
+                    case BENCH_ARRAY_PUSH_N: {
+                        Vertex *items = array.push_n(count);
+                        for (u32 i = 0; i < count; ++i) {
+                            items[i] = source.data[i];
+                        }
+                    } break;
+
+                    case BENCH_ARRAY_APPEND: {
+                        array.append(source.data, count);
+                    } break;
+
+                    INVALID_DEFAULT_CASE;
+                }
+                f64 end = linux_get_seconds();
+
+                ASSERT(array.count == count && array.data[count - 1].texture == source.data[count - 1].texture);
+                best_ms = MIN(best_ms, (end - begin)*1000.0);
+                allocs = bench_alloc_count;
+                array.free();
+            }
+
+            printf("%10u %12s %12.3f %10u\n", count, path_names[path], best_ms, allocs);
+        }
+        source.free();
+    }
+
+    os.alloc = alloc;
+}
+
+
+//
+// Arena
+//
+function void
+bench_arena(void) {
+    u32 alloc_count = 10000;
+    umm sizes[] = {64, 4096, 256 << 10};
+    printf("== scratch allocation (%u alloc/free pairs) ==\n", alloc_count);
+    printf("%10s %14s %14s %14s\n", "bytes", "os.alloc ns", "arena ns", "arena cold ns");
+
+    for (u32 s = 0; s < arraycount(sizes); ++s) {
+        umm size = sizes[s];
+
+        // @NOTE: Each block gets one write, like a scratch array that's filled.
+        f64 begin = linux_get_seconds();
+        for (u32 i = 0; i < alloc_count; ++i) {
+            u8 *block = (u8 *)os.alloc(size);
+            block[size - 1] = (u8)i;
+            os.free(block);
+        }
+        f64 os_ns = (linux_get_seconds() - begin)*1e9 / alloc_count;
+
+        Memory_Arena arena{};
+        begin = linux_get_seconds();
+        for (u32 i = 0; i < alloc_count; ++i) {
+            TEMP_MEMORY_SCOPE(&arena);
+            u8 *block = push_array(&arena, u8, size);
+            block[size - 1] = (u8)i;
+        }
+        f64 arena_ns = (linux_get_seconds() - begin)*1e9 / alloc_count;
+        arena_free(&arena);
+
+        // @NOTE: A fresh arena per allocation: reserve, commit and fault every time.
+        begin = linux_get_seconds();
+        for (u32 i = 0; i < alloc_count; ++i) {
+            Memory_Arena cold{};
+            u8 *block = push_array(&cold, u8, size);
+            block[size - 1] = (u8)i;
+            arena_free(&cold);
+        }
+        f64 cold_ns = (linux_get_seconds() - begin)*1e9 / alloc_count;
+
+        printf("%10zu %14.1f %14.1f %14.1f\n", (size_t)size, os_ns, arena_ns, cold_ns);
+    }
+}
+
+
+//
+// Hashing
+//
+function u64
+bench_fnv1a(void *data, umm size) {
+    u8 *p = (u8 *)data;
+    u64 h = 0xCBF29CE484222325ull;
+    for (umm i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+function void
+bench_hashing(void) {
+    printf("== hashing ==\n");
+
+    // @NOTE: asset_id() runs in the compiler; this fails to build otherwise.
+    static_assert(ASSET_ID("doggo.png") == asset_id("doggo.png"), "ASSET_ID should be a constant.");
+    char name[] = "doggo.png";
+    ASSERT(asset_id(name) == ASSET_ID("doggo.png"));
+
+    u32 key_count = 1 << 20;
+    u64 sink = 0;
+    f64 begin = linux_get_seconds();
+    for (u32 key = 0; key < key_count; ++key) {
+        sink += hash(key);
+    }
+    f64 mix_ns = (linux_get_seconds() - begin)*1e9 / key_count;
+    printf("%-24s %8.2f ns/key\n", "hash(u32)", mix_ns);
+
+    umm sizes[] = {8, 32, 256, 4096, 1 << 20};
+    umm max_size = sizes[arraycount(sizes) - 1];
+    u8 *bytes = (u8 *)os.alloc(max_size);
+    for (umm i = 0; i < max_size; ++i) {
+        bytes[i] = (u8)(i*131 + 7);
+    }
+
+    printf("%10s %14s %14s\n", "bytes", "wyhash GB/s", "fnv1a GB/s");
+    for (u32 s = 0; s < arraycount(sizes); ++s) {
+        umm size = sizes[s];
+        u32 reps = (u32)MAX((umm)1, ((umm)64 << 20) / size);
+
+        begin = linux_get_seconds();
+        for (u32 r = 0; r < reps; ++r) {
+            sink += hash_bytes(bytes, size, r);
+        }
+        f64 wy_s = linux_get_seconds() - begin;
+
+        begin = linux_get_seconds();
+        for (u32 r = 0; r < reps; ++r) {
+            bytes[0] = (u8)r;
+            sink += bench_fnv1a(bytes, size);
+        }
+        f64 fnv_s = linux_get_seconds() - begin;
+
+        f64 total = (f64)size*reps;
+        printf("%10zu %14.2f %14.2f\n", (size_t)size, total/wy_s*1e-9, total/fnv_s*1e-9);
+    }
+    os.free(bytes);
+
+    // @NOTE: Keeps the loops from being thrown away.
+    if (sink == 42) {
+        printf("\n");
+    }
+}
+
+
+//
+// Hash table
+//
+
+// @NOTE: The chained table Hash_Table replaced: 32 buckets, never resized, one
+// os.alloc per node.
+struct Bench_Chained_Node {
+    u32 key;
+    u32 value;
+    Bench_Chained_Node *next;
+};
+
+struct Bench_Chained_Table {
+    Bench_Chained_Node *sentinels;
+    umm sentinel_count;
+
+    void init(umm sentinel_count_) {
+        sentinel_count = sentinel_count_;
+        sentinels = (Bench_Chained_Node *)os.alloc(sizeof(Bench_Chained_Node) * sentinel_count);
+        for (umm i = 0; i < sentinel_count; ++i) {
+            sentinels[i].next = sentinels + i;
+        }
+    }
+
+    void insert(u32 key, u32 value) {
+        Bench_Chained_Node *sentinel = sentinels + hash(key) % sentinel_count;
+        Bench_Chained_Node *node = sentinel;
+        while (node->next != sentinel) {
+            node = node->next;
+        }
+        Bench_Chained_Node *new_node = (Bench_Chained_Node *)os.alloc(sizeof(Bench_Chained_Node));
+        new_node->key = key;
+        new_node->value = value;
+        new_node->next = sentinel;
+        node->next = new_node;
+    }
+
+    b32 remove(u32 key) {
+        Bench_Chained_Node *sentinel = sentinels + hash(key) % sentinel_count;
+        for (Bench_Chained_Node *prev = sentinel; prev->next != sentinel; prev = prev->next) {
+            Bench_Chained_Node *node = prev->next;
+            if (node->key == key) {
+                prev->next = node->next;
+                os.free(node);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Hash_Get_Result<u32> get(u32 key) {
+        Hash_Get_Result<u32> result{};
+        Bench_Chained_Node *sentinel = sentinels + hash(key) % sentinel_count;
+        for (Bench_Chained_Node *node = sentinel->next; node != sentinel; node = node->next) {
+            if (node->key == key) {
+                result.found = true;
+                result.value = node->value;
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+struct Bench_Table_Times {
+    f64 insert_ms;
+    f64 hit_ms;
+    f64 miss_ms;
+    f64 remove_ms;
+};
+
+// @NOTE: Keys are sequential, like image ids; misses are the next key_count ids.
+template<typename Table>
+function Bench_Table_Times
+bench_table(Table *table, u32 key_count) {
+    Bench_Table_Times result{};
+    u32 found = 0;
+
+    f64 begin = linux_get_seconds();
+    for (u32 key = 1; key <= key_count; ++key) {
+        table->insert(key, key*3);
+    }
+    f64 inserted = linux_get_seconds();
+    for (u32 key = 1; key <= key_count; ++key) {
+        found += (table->get(key).value == key*3);
+    }
+    f64 hit = linux_get_seconds();
+    for (u32 key = key_count + 1; key <= 2*key_count; ++key) {
+        found += table->get(key).found;
+    }
+    f64 missed = linux_get_seconds();
+    for (u32 key = 1; key <= key_count; ++key) {
+        table->remove(key);
+    }
+    f64 removed = linux_get_seconds();
+
+    ASSERT(found == key_count);
+    result.insert_ms = (inserted - begin)*1000.0;
+    result.hit_ms    = (hit - inserted)*1000.0;
+    result.miss_ms   = (missed - hit)*1000.0;
+    result.remove_ms = (removed - missed)*1000.0;
+    return result;
+}
+
+function void
+bench_hash_table(void) {
+    u32 key_counts[] = {10, 1000, 10000, 100000, 1000000};
+    printf("== hash table (u32 -> u32, sequential keys) ==\n");
+    printf("%10s %8s %12s %12s %12s %12s %12s\n", "keys", "table", "insert ms", "hit ms", "miss ms", "remove ms", "iterate ms");
+
+    for (u32 k = 0; k < arraycount(key_counts); ++k) {
+        u32 key_count = key_counts[k];
+
+        // @NOTE: Chains are key_count/32 long; past 10k a run takes minutes.
+        if (key_count <= 10000) {
+            Bench_Chained_Table chained{};
+            chained.init(32);
+            Bench_Table_Times times = bench_table(&chained, key_count);
+            printf("%10u %8s %12.3f %12.3f %12.3f %12.3f %12s\n", key_count, "chained",
+                   times.insert_ms, times.hit_ms, times.miss_ms, times.remove_ms, "-");
+            os.free(chained.sentinels);
+        }
+
+        Hash_Table<u32, u32> table{};
+        Bench_Table_Times times = bench_table(&table, key_count);
+        ASSERT(table.count == 0);
+
+        // @NOTE: Iterate a full table; the last bench_table() pass emptied it.
+        for (u32 key = 1; key <= key_count; ++key) {
+            table.insert(key, key);
+        }
+        u64 sum = 0;
+        f64 begin = linux_get_seconds();
+        umm cursor = 0;
+        while (Pair<u32, u32> *slot = table.next(&cursor)) {
+            sum += slot->b;
+        }
+        f64 iterate_ms = (linux_get_seconds() - begin)*1000.0;
+        ASSERT(sum == (u64)key_count*(key_count + 1)/2);
+
+        printf("%10u %8s %12.3f %12.3f %12.3f %12.3f %12.3f\n", key_count, "swiss",
+               times.insert_ms, times.hit_ms, times.miss_ms, times.remove_ms, iterate_ms);
+
+        Hash_Table<u32, u32> reserved{};
+        reserved.reserve(key_count);
+        times = bench_table(&reserved, key_count);
+        printf("%10u %8s %12.3f %12.3f %12.3f %12.3f %12s\n", key_count, "reserved",
+               times.insert_ms, times.hit_ms, times.miss_ms, times.remove_ms, "-");
+
+        table.free();
+        reserved.free();
+    }
+}
+
+
+//
+// Pool
+//
+struct Bench_Node {
+    u32 key;
+    u32 value;
+    Bench_Node *next;
+    u64 pad;
+};
+
+function void
+bench_pool(void) {
+    u32 counts[] = {1000, 10000, 100000};
+    printf("== pool (%zu-byte nodes: alloc all, free all, alloc all again) ==\n", sizeof(Bench_Node));
+    printf("%10s %12s %12s %14s %14s %8s %8s\n", "nodes", "os ns/op", "pool ns/op", "os bytes", "pool bytes", "peak", "slabs");
+
+    for (u32 c = 0; c < arraycount(counts); ++c) {
+        u32 count = counts[c];
+        Bench_Node **nodes = (Bench_Node **)os.alloc(sizeof(Bench_Node *)*count);
+
+        Os_Alloc_Stats before = os.alloc_stats();
+        s64 os_bytes = 0;
+        f64 begin = linux_get_seconds();
+        for (u32 round = 0; round < 2; ++round) {
+            for (u32 i = 0; i < count; ++i) {
+                nodes[i] = (Bench_Node *)os.alloc(sizeof(Bench_Node));
+                nodes[i]->key = i;
+            }
+            if (round == 0) {
+                os_bytes = os.alloc_stats().live_bytes - before.live_bytes;
+            }
+            for (u32 i = 0; i < count; ++i) {
+                os.free(nodes[i]);
+            }
+        }
+        f64 os_ns = (linux_get_seconds() - begin)*1e9 / (4.0*count);
+
+        // @NOTE: Frees in reverse, so the second round walks the free list backwards
+        // through memory, like nodes freed in no particular order.
+        Pool<Bench_Node> pool{};
+        begin = linux_get_seconds();
+        for (u32 round = 0; round < 2; ++round) {
+            for (u32 i = 0; i < count; ++i) {
+                nodes[i] = pool.alloc();
+                nodes[i]->key = i;
+            }
+            for (u32 i = count; i > 0; --i) {
+                pool.free(nodes[i - 1]);
+            }
+        }
+        f64 pool_ns = (linux_get_seconds() - begin)*1e9 / (4.0*count);
+        Pool_Stats stats = pool.stats;
+        ASSERT(stats.live == 0 && stats.peak == count);
+
+        printf("%10u %12.1f %12.1f %14zu %14zu %8u %8u\n", count, os_ns, pool_ns,
+               (size_t)os_bytes, (size_t)stats.slab_bytes, stats.peak, stats.slab_count);
+
+        pool.free_all();
+        os.free(nodes);
+    }
+}
+
+
+//
+// Allocator
+//
+// @NOTE: Baseline: what linux_alloc used to be, a mapping per block with its
+// size in a header in front.
+function void *
+bench_mmap_alloc(umm size) {
+    umm mapped_size = size + 64;
+    u8 *base = (u8 *)mmap(0, mapped_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    *(umm *)base = mapped_size;
+    return base + 64;
+}
+
+function void
+bench_mmap_free(void *memory) {
+    u8 *base = (u8 *)memory - 64;
+    munmap(base, *(umm *)base);
+}
+
+#define BENCH_ALLOC_CHURN_SLOTS 4096
+
+struct Bench_Alloc_Thread {
+    u32 seed;
+    u32 op_count;
+};
+
+// @NOTE: Keeps a window of live blocks of random sizes up to 1 KB and replaces a
+// random one per op, touching each new block once. Spans are never unmapped, so
+// mapped only grows when the heap's lists can't cover a run.
+function void *
+bench_alloc_churn(void *data) {
+    Bench_Alloc_Thread *thread = (Bench_Alloc_Thread *)data;
+    void **slots = (void **)os.alloc(sizeof(void *)*BENCH_ALLOC_CHURN_SLOTS);
+    u32 seed = thread->seed;
+    for (u32 op = 0; op < thread->op_count; ++op) {
+        seed = seed*1664525 + 1013904223;
+        u32 slot = (seed >> 8) % BENCH_ALLOC_CHURN_SLOTS;
+        umm size = 1 + ((seed >> 20) & 1023);
+        os.free(slots[slot]);
+        slots[slot] = os.alloc(size);
+        ((u8 *)slots[slot])[size - 1] = 1;
+    }
+    for (u32 i = 0; i < BENCH_ALLOC_CHURN_SLOTS; ++i) {
+        os.free(slots[i]);
+    }
+    os.free(slots);
+    return 0;
+}
+
+function void
+bench_allocator(void) {
+    u32 sizes[] = {16, 100, 1024, 8192, 65536};
+    u32 count = 20000;
+    void **blocks = (void **)os.alloc(sizeof(void *)*count);
+
+    printf("== allocator (%u blocks: alloc all, free all, twice; ns per alloc+free) ==\n", count);
+    printf("%10s %12s %12s %12s\n", "size", "mmap", "os.alloc", "calloc");
+    for (u32 s = 0; s < arraycount(sizes); ++s) {
+        umm size = sizes[s];
+        f64 ns[3];
+        for (u32 kind = 0; kind < 3; ++kind) {
+            f64 begin = linux_get_seconds();
+            for (u32 round = 0; round < 2; ++round) {
+                for (u32 i = 0; i < count; ++i) {
+                    switch (kind) {
+                        case 0: blocks[i] = bench_mmap_alloc(size); break;
+                        case 1: blocks[i] = os.alloc(size); break;
+                        case 2: blocks[i] = calloc(1, size); break;
+                    }
+                    ((u8 *)blocks[i])[0] = 1;
+                }
+                for (u32 i = 0; i < count; ++i) {
+                    switch (kind) {
+                        case 0: bench_mmap_free(blocks[i]); break;
+                        case 1: os.free(blocks[i]); break;
+                        case 2: free(blocks[i]); break;
+                    }
+                }
+            }
+            ns[kind] = (linux_get_seconds() - begin)*1e9 / (2.0*count);
+        }
+        printf("%10zu %12.1f %12.1f %12.1f\n", (size_t)size, ns[0], ns[1], ns[2]);
+    }
+    os.free(blocks);
+
+    u32 op_count = 1 << 21;
+    u32 thread_counts[] = {1, 2, 4};
+    printf("== allocator churn (%u live blocks of 1..1024 bytes per thread, %u ops per thread, %u cores) ==\n",
+           BENCH_ALLOC_CHURN_SLOTS, op_count, (u32)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%10s %12s %14s %14s %14s\n", "threads", "M ops/s", "allocs", "live bytes", "mapped delta");
+    for (u32 t = 0; t < arraycount(thread_counts); ++t) {
+        u32 thread_count = thread_counts[t];
+        Bench_Alloc_Thread threads[4];
+        pthread_t handles[4];
+        Os_Alloc_Stats before = os.alloc_stats();
+        f64 begin = linux_get_seconds();
+        for (u32 i = 0; i < thread_count; ++i) {
+            threads[i].seed = 12345 + i;
+            threads[i].op_count = op_count;
+            pthread_create(handles + i, 0, bench_alloc_churn, threads + i);
+        }
+        for (u32 i = 0; i < thread_count; ++i) {
+            pthread_join(handles[i], 0);
+        }
+        f64 seconds = linux_get_seconds() - begin;
+        Os_Alloc_Stats after = os.alloc_stats();
+        printf("%10u %12.1f %14llu %14lld %14llu\n", thread_count, thread_count*op_count / seconds * 1e-6,
+               (unsigned long long)(after.alloc_count - before.alloc_count), (long long)after.live_bytes,
+               (unsigned long long)(after.mapped_bytes - before.mapped_bytes));
+    }
+}
+
+
+//
+// Memory hints
+//
+function u64
+bench_minor_faults(void) {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (u64)usage.ru_minflt;
+}
+
+function void
+bench_print_file(const char *label, const char *path) {
+    char line[256] = {};
+    FILE *file = fopen(path, "r");
+    if (file) {
+        if (!fgets(line, sizeof(line), file)) {
+            line[0] = 0;
+        }
+        fclose(file);
+    }
+    line[strcspn(line, "\n")] = 0;
+    printf("%s: %s\n", label, file ? line : "n/a");
+}
+
+// @NOTE: Fills a fresh vertex stream the way a frame after a resize does, growing
+// from empty, then pushes the same count again into the warm array and reads it
+// back in random order to show the TLB side.
+function void
+bench_memory_hints(void) {
+    struct Config {
+        const char *name;
+        u32 flags;
+    };
+    Config configs[] = {
+        {"none",           0},
+        {"huge",           OS_MEMORY_HUGE_PAGES},
+        {"prefault",       OS_MEMORY_PREFAULT},
+        {"huge+prefault",  OS_MEMORY_HUGE_PAGES|OS_MEMORY_PREFAULT},
+        {"hugetlb+pref",   OS_MEMORY_HUGETLB|OS_MEMORY_PREFAULT},
+    };
+    u32 count = 1 << 20;
+    u32 read_count = 1 << 22;
+
+    printf("== memory hints (%u vertices, %zu MB) ==\n", count, (size_t)(sizeof(Vertex)*count >> 20));
+    bench_print_file("thp", "/sys/kernel/mm/transparent_hugepage/enabled");
+    bench_print_file("hugetlb pages", "/proc/sys/vm/nr_hugepages");
+    printf("%14s %10s %10s %12s %10s %12s\n", "flags", "cold ms", "faults", "warm M/s", "faults", "rand read ns");
+
+    for (u32 c = 0; c < arraycount(configs); ++c) {
+        Dynamic_Array<Vertex> vertices{};
+        vertices.memory_flags = configs[c].flags;
+        Vertex v{V2(1, 2), V4(1, 1, 1, 1), V2(0, 1), 3};
+
+        u64 faults = bench_minor_faults();
+        f64 begin = linux_get_seconds();
+        for (u32 i = 0; i < count; ++i) {
+            v.texture = i;
+            vertices.push(v);
+        }
+        f64 cold_ms = (linux_get_seconds() - begin)*1000.0;
+        u64 cold_faults = bench_minor_faults() - faults;
+
+        vertices.clear();
+        faults = bench_minor_faults();
+        begin = linux_get_seconds();
+        for (u32 i = 0; i < count; ++i) {
+            v.texture = i;
+            vertices.push(v);
+        }
+        f64 warm_rate = count / (linux_get_seconds() - begin) * 1e-6;
+        u64 warm_faults = bench_minor_faults() - faults;
+
+        u32 seed = 1;
+        u32 sink = 0;
+        begin = linux_get_seconds();
+        for (u32 i = 0; i < read_count; ++i) {
+            seed = seed*1664525 + 1013904223;
+            sink += vertices.data[(seed >> 8) & (count - 1)].texture;
+        }
+        f64 read_ns = (linux_get_seconds() - begin)*1e9 / read_count;
+        if (sink == 42) {
+            printf("\n");
+        }
+
+        printf("%14s %10.2f %10llu %12.1f %10llu %12.2f\n", configs[c].name, cold_ms,
+               (unsigned long long)cold_faults, warm_rate, (unsigned long long)warm_faults, read_ns);
+        vertices.free();
+    }
+
+    umm arena_size = (umm)64 << 20;
+    printf("== arena hints (push %zu MB in 64 KB pieces, touch each) ==\n", (size_t)(arena_size >> 20));
+    printf("%14s %10s %10s\n", "flags", "ms", "faults");
+    for (u32 c = 0; c < arraycount(configs); ++c) {
+        Memory_Arena arena{};
+        arena.flags = configs[c].flags;
+        umm piece = (umm)64 << 10;
+
+        u64 faults = bench_minor_faults();
+        f64 begin = linux_get_seconds();
+        for (umm used = 0; used < arena_size; used += piece) {
+            u8 *memory = (u8 *)push_size(&arena, piece);
+            for (umm at = 0; at < piece; at += 4096) {
+                memory[at] = 1;
+            }
+        }
+        f64 ms = (linux_get_seconds() - begin)*1000.0;
+        printf("%14s %10.2f %10llu\n", configs[c].name, ms, (unsigned long long)(bench_minor_faults() - faults));
+        arena_free(&arena);
+    }
+}
+
+
+//
+// Queues
+//
+#define BENCH_QUEUE_CAPACITY 1024
+
+// @NOTE: Baseline: a ring behind a spin lock.
+struct Bench_Locked_Queue {
+    volatile u32 lock;
+    u32 read;
+    u32 write;
+    u32 items[BENCH_QUEUE_CAPACITY];
+
+    b32 push(u32 item) {
+        spin_lock(&lock);
+        b32 result = (write - read < BENCH_QUEUE_CAPACITY);
+        if (result) {
+            items[write++ & (BENCH_QUEUE_CAPACITY - 1)] = item;
+        }
+        spin_unlock(&lock);
+        return result;
+    }
+
+    b32 pop(u32 *item) {
+        spin_lock(&lock);
+        b32 result = (write != read);
+        if (result) {
+            *item = items[read++ & (BENCH_QUEUE_CAPACITY - 1)];
+        }
+        spin_unlock(&lock);
+        return result;
+    }
+};
+
+// @NOTE: Chunked_Queue::push can't fail; this gives it the same shape as the rest.
+struct Bench_Chunked_Queue {
+    Chunked_Queue<u32> queue;
+
+    b32 push(u32 item) {
+        queue.push(item);
+        return true;
+    }
+
+    b32 pop(u32 *item) {
+        return queue.pop(item);
+    }
+};
+
+struct Bench_Queue_Job {
+    void *queue;
+    u32 first;
+    u32 count;
+    u64 sum;
+};
+
+// @NOTE: Yields on full or empty; with fewer cores than threads, spinning would
+// just burn the other side's time slice.
+template<typename Q>
+function void *
+bench_queue_producer(void *param) {
+    Bench_Queue_Job *job = (Bench_Queue_Job *)param;
+    Q *queue = (Q *)job->queue;
+    for (u32 i = 0; i < job->count; ++i) {
+        while (!queue->push(job->first + i)) {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+template<typename Q>
+function void *
+bench_queue_consumer(void *param) {
+    Bench_Queue_Job *job = (Bench_Queue_Job *)param;
+    Q *queue = (Q *)job->queue;
+    u64 sum = 0;
+    for (u32 i = 0; i < job->count; ++i) {
+        u32 item;
+        while (!queue->pop(&item)) {
+            sched_yield();
+        }
+        sum += item;
+    }
+    job->sum = sum;
+    return 0;
+}
+
+// @NOTE: Returns million items per second through the queue. Producers push
+// disjoint ranges of 1..item_count; the consumers' sums have to add up.
+template<typename Q>
+function f64
+bench_queue_threads(u32 producer_count, u32 consumer_count, u32 item_count) {
+    Q *queue = (Q *)os.alloc(sizeof(Q));
+    Bench_Queue_Job producers[4] = {};
+    Bench_Queue_Job consumers[4] = {};
+    pthread_t threads[8];
+    ASSERT(producer_count <= 4 && consumer_count <= 4);
+
+    f64 begin = linux_get_seconds();
+    u32 thread_count = 0;
+    for (u32 i = 0; i < consumer_count; ++i) {
+        consumers[i] = {queue, 0, item_count / consumer_count, 0};
+        pthread_create(threads + thread_count++, 0, bench_queue_consumer<Q>, consumers + i);
+    }
+    for (u32 i = 0; i < producer_count; ++i) {
+        u32 count = item_count / producer_count;
+        producers[i] = {queue, 1 + i*count, count, 0};
+        pthread_create(threads + thread_count++, 0, bench_queue_producer<Q>, producers + i);
+    }
+    for (u32 i = 0; i < thread_count; ++i) {
+        pthread_join(threads[i], 0);
+    }
+    f64 seconds = linux_get_seconds() - begin;
+
+    u64 sum = 0;
+    for (u32 i = 0; i < consumer_count; ++i) {
+        sum += consumers[i].sum;
+    }
+    ASSERT(sum == (u64)item_count*(item_count + 1)/2);
+    os.free(queue);
+    return item_count / seconds * 1e-6;
+}
+
+// @NOTE: One thread, pushing a burst and popping it back; no contention at all.
+template<typename Q>
+function f64
+bench_queue_single(u32 item_count) {
+    Q *queue = (Q *)os.alloc(sizeof(Q));
+    u32 burst = BENCH_QUEUE_CAPACITY/2;
+    u64 sum = 0;
+    f64 begin = linux_get_seconds();
+    for (u32 first = 0; first < item_count; first += burst) {
+        for (u32 i = 0; i < burst; ++i) {
+            queue->push(first + i);
+        }
+        for (u32 i = 0; i < burst; ++i) {
+            u32 item = 0;
+            queue->pop(&item);
+            sum += item;
+        }
+    }
+    f64 seconds = linux_get_seconds() - begin;
+    ASSERT(sum == (u64)item_count*(item_count - 1)/2);
+    os.free(queue);
+    return item_count / seconds * 1e-6;
+}
+
+function void
+bench_queues(void) {
+    typedef Spsc_Queue<u32, BENCH_QUEUE_CAPACITY> Spsc;
+    typedef Mpmc_Queue<u32, BENCH_QUEUE_CAPACITY> Mpmc;
+    u32 item_count = 1 << 22;
+    printf("== queues (%u u32 items, capacity %u, %ld cores) ==\n", item_count, BENCH_QUEUE_CAPACITY,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%10s %12s %12s %12s %12s\n", "threads", "locked M/s", "spsc M/s", "mpmc M/s", "chunked M/s");
+
+    printf("%10s %12.1f %12.1f %12.1f %12.1f\n", "1",
+           bench_queue_single<Bench_Locked_Queue>(item_count), bench_queue_single<Spsc>(item_count),
+           bench_queue_single<Mpmc>(item_count), bench_queue_single<Bench_Chunked_Queue>(item_count));
+    printf("%10s %12.1f %12.1f %12.1f %12.1f\n", "1p/1c",
+           bench_queue_threads<Bench_Locked_Queue>(1, 1, item_count), bench_queue_threads<Spsc>(1, 1, item_count),
+           bench_queue_threads<Mpmc>(1, 1, item_count), bench_queue_threads<Bench_Chunked_Queue>(1, 1, item_count));
+    printf("%10s %12.1f %12s %12.1f %12s\n", "2p/2c",
+           bench_queue_threads<Bench_Locked_Queue>(2, 2, item_count), "-",
+           bench_queue_threads<Mpmc>(2, 2, item_count), "-");
+    printf("%10s %12.1f %12s %12.1f %12s\n", "4p/4c",
+           bench_queue_threads<Bench_Locked_Queue>(4, 4, item_count), "-",
+           bench_queue_threads<Mpmc>(4, 4, item_count), "-");
+}
+
+
+//
+// Atlas
+//
+global Atlas_Page bench_atlas_pages[64];
+
+function void
+bench_atlas(void) {
+    printf("== atlas (random 8..%u px images, %u^2 pages) ==\n", RENDERER_ATLAS_MAX_IMAGE_DIM, ATLAS_PAGE_DIM);
+    printf("%10s %12s %8s %12s\n", "images", "pack ms", "pages", "occupancy");
+
+    Atlas_Page *pages = bench_atlas_pages;
+    u32 image_counts[] = {100, 1000, 10000};
+    for (u32 i = 0; i < arraycount(image_counts); ++i) {
+        u32 image_count = image_counts[i];
+        srand(1234);
+
+        u32 page_count = 1;
+        atlas_page_init(pages, 0);
+
+        f64 begin = linux_get_seconds();
+        for (u32 image = 0; image < image_count; ++image) {
+            u32 width  = 8 + (u32)(rand01()*(RENDERER_ATLAS_MAX_IMAGE_DIM - 8)) + 2*RENDERER_ATLAS_PADDING;
+            u32 height = 8 + (u32)(rand01()*(RENDERER_ATLAS_MAX_IMAGE_DIM - 8)) + 2*RENDERER_ATLAS_PADDING;
+            u32 x, y;
+            if (!atlas_page_pack(pages + page_count - 1, width, height, &x, &y)) {
+                ASSERT(page_count < arraycount(bench_atlas_pages));
+                atlas_page_init(pages + page_count, page_count);
+                ++page_count;
+                b32 packed = atlas_page_pack(pages + page_count - 1, width, height, &x, &y);
+                ASSERT(packed);
+            }
+        }
+        f64 pack_ms = (linux_get_seconds() - begin)*1000.0;
+
+        u64 used_area = 0;
+        for (u32 page = 0; page < page_count; ++page) {
+            used_area += pages[page].used_area;
+        }
+        f64 occupancy = (f64)used_area / ((f64)page_count*ATLAS_PAGE_DIM*ATLAS_PAGE_DIM);
+        printf("%10u %12.3f %8u %11.1f%%\n", image_count, pack_ms, page_count, occupancy*100.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    os.alloc        = linux_alloc;
+    os.alloc_hinted = linux_alloc_hinted;
+    os.free         = linux_free;
+    os.alloc_stats  = linux_alloc_stats;
+    os.reserve      = linux_reserve;
+    os.commit       = linux_commit;
+    os.release      = linux_release;
+
+    g_renderer = &renderer;
+    renderer_set_memory_hints(&renderer);
+
+    b32 full = false;
+    for (int i = 1; i < argc; ++i) {
+        if (cstring_equal(argv[i], "--full")) {
+            full = true;
+        }
+    }
+
+    bench_arena();
+    bench_dynamic_array();
+    bench_pool();
+    bench_allocator();
+    bench_memory_hints();
+    bench_hashing();
+    bench_hash_table();
+    bench_sort(full);
+    bench_quads();
+    bench_batch_quads();
+    bench_static_batches();
+    bench_opacity();
+    bench_clips();
+    bench_hierarchy();
+    bench_culling();
+    bench_threaded_push();
+    bench_queues();
+    bench_atlas();
+
+    return 0;
+}
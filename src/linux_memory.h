@@ -0,0 +1,470 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+// @NOTE: General-purpose allocator behind os.alloc/os.free.
+//
+// Memory comes in spans of LINUX_SPAN_SIZE, aligned to their size, with a
+// Linux_Span header at the start; os.free finds it by masking the pointer. Blocks
+// up to LINUX_SMALL_SIZE_MAX are rounded up to a size class and carved out of
+// spans that come from LINUX_REGION_SIZE mappings. Freed small blocks go on the
+// calling thread's cache and are handed out again from there; the cache trades
+// batches with the heap's per-class lists, under its lock, when it runs dry or
+// gets too full. Spans and regions are never unmapped. Anything bigger gets its
+// own mapping, with the span header in front, and is unmapped on free.
+//
+// Blocks are 16-byte aligned, and 64-byte aligned when the size is a multiple of
+// 64. Every block comes back zeroed, per Os.
+//
+// The exe and the renderer .so each have a copy of this, with their own heap and
+// caches. Every span header points at the heap it came from, so either side can
+// free the other's blocks: they go back on the owning heap's lists and come off
+// its counters, not the freeing side's.
+#define LINUX_SPAN_SIZE             ((umm)64 << 10)
+#define LINUX_SPAN_HEADER_SIZE      64
+#define LINUX_REGION_SIZE           ((umm)4 << 20)
+#define LINUX_SMALL_SIZE_MAX        8192
+#define LINUX_SIZE_CLASS_COUNT      32
+#define LINUX_SIZE_CLASS_LARGE      0xFFFFFFFF
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE         23
+#endif
+
+// @NOTE: 16-byte steps up to 128, then four steps per power of two.
+global u32 linux_size_classes[LINUX_SIZE_CLASS_COUNT] = {
+      16,   32,   48,   64,   80,   96,  112,  128,
+     160,  192,  224,  256,  320,  384,  448,  512,
+     640,  768,  896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+};
+
+struct Linux_Heap;
+
+struct Linux_Span {
+    u32 size_class;             // LINUX_SIZE_CLASS_LARGE for a block with its own mapping
+    u32 block_size;
+    umm mapped_size;            // large blocks only
+    Linux_Heap *heap;           // the one that mapped it
+};
+
+struct Linux_Free_Block {
+    Linux_Free_Block *next;
+};
+
+struct Linux_Thread_Cache {
+    Linux_Free_Block *free_lists[LINUX_SIZE_CLASS_COUNT];
+    u32 counts[LINUX_SIZE_CLASS_COUNT];
+
+    // @NOTE: Only written by the owning thread; alloc_stats() sums them racily.
+    // A block freed on another thread than it was allocated on makes live_bytes
+    // go negative on one and over on the other.
+    u64 alloc_count;
+    u64 free_count;
+    s64 live_bytes;
+
+    Linux_Thread_Cache *next;           // every cache the heap has made
+    Linux_Thread_Cache *next_unused;    // left behind by exited threads
+};
+
+struct Linux_Heap {
+    volatile u32 lock;
+    Linux_Free_Block *free_lists[LINUX_SIZE_CLASS_COUNT];
+    u8 *region_at;
+    u8 *region_end;
+
+    Linux_Thread_Cache *caches;
+    Linux_Thread_Cache *unused_caches;
+    b32 thread_key_created;
+    pthread_key_t thread_key;
+
+    volatile u64 mapped_bytes;
+
+    // @NOTE: Frees of this heap's blocks from the other module, which can't touch
+    // our thread caches' counters.
+    volatile u64 remote_free_count;
+    volatile u64 remote_freed_bytes;
+};
+
+global Linux_Heap linux_heap;
+global thread_local Linux_Thread_Cache *linux_thread_cache;
+
+function u32
+linux_size_class(umm size) {
+    u32 result;
+    if (size <= 128) {
+        result = (size == 0) ? 0 : (u32)((size - 1) >> 4);
+    } else {
+        u32 high_bit = find_most_significant_set_bit((u32)(size - 1));
+        u32 step = (u32)((size - 1) >> (high_bit - 2)) & 3;
+        result = 8 + 4*(high_bit - 7) + step;
+    }
+    ASSERT(result < LINUX_SIZE_CLASS_COUNT && size <= linux_size_classes[result]);
+    return result;
+}
+
+// @NOTE: Blocks moved between a thread cache and the heap at a time; a cache
+// holds up to twice this. About 16 KB worth, so big classes don't pile up.
+function u32
+linux_cache_batch(u32 size_class) {
+    u32 result = (16 << 10) / linux_size_classes[size_class];
+    result = MAX(2, MIN(64, result));
+    return result;
+}
+
+// @NOTE: mmap only promises page alignment, so this maps an extra alignment's
+// worth and trims both ends.
+function void *
+linux_map_aligned(umm size, umm alignment, int prot = PROT_READ|PROT_WRITE, int map_flags = 0) {
+    umm mapped_size = size + alignment;
+    u8 *base = (u8 *)mmap(0, mapped_size, prot, MAP_PRIVATE|MAP_ANONYMOUS|map_flags, -1, 0);
+    if (base == MAP_FAILED) {
+        return 0;
+    }
+    u8 *result = (u8 *)(((umm)base + alignment - 1) & ~(alignment - 1));
+    if (result > base) {
+        munmap(base, result - base);
+    }
+    u8 *end = base + mapped_size;
+    if (end > result + size) {
+        munmap(result + size, end - (result + size));
+    }
+    return result;
+}
+
+// @NOTE: MADV_POPULATE_WRITE is Linux 5.14+; older kernels get a write per page,
+// which rewrites what's there, so it's safe on memory already in use.
+function void
+linux_prefault(void *memory, umm size) {
+    if (madvise(memory, size, MADV_POPULATE_WRITE) != 0) {
+        umm page_size = (umm)sysconf(_SC_PAGESIZE);
+        for (volatile u8 *at = (u8 *)memory; at < (u8 *)memory + size; at += page_size) {
+            *at = *at;
+        }
+    }
+}
+
+function
+OS_ALLOC_STATS(linux_alloc_stats) {
+    Os_Alloc_Stats result{};
+    spin_lock(&linux_heap.lock);
+    for (Linux_Thread_Cache *cache = linux_heap.caches; cache; cache = cache->next) {
+        result.alloc_count += cache->alloc_count;
+        result.free_count  += cache->free_count;
+        result.live_bytes  += cache->live_bytes;
+    }
+    spin_unlock(&linux_heap.lock);
+    result.free_count  += linux_heap.remote_free_count;
+    result.live_bytes  -= (s64)linux_heap.remote_freed_bytes;
+    result.mapped_bytes = linux_heap.mapped_bytes;
+    return result;
+}
+
+// @NOTE: Caller holds the heap lock.
+function void
+linux_heap_push_blocks(Linux_Heap *heap, u32 size_class, Linux_Free_Block *first, Linux_Free_Block *last) {
+    last->next = heap->free_lists[size_class];
+    heap->free_lists[size_class] = first;
+}
+
+// @NOTE: pthread destructor; hands the exiting thread's blocks back to the heap
+// and keeps its cache, counters and all, for the next thread.
+function void
+linux_thread_cache_exit(void *data) {
+    Linux_Thread_Cache *cache = (Linux_Thread_Cache *)data;
+    spin_lock(&linux_heap.lock);
+    for (u32 size_class = 0; size_class < LINUX_SIZE_CLASS_COUNT; ++size_class) {
+        Linux_Free_Block *first = cache->free_lists[size_class];
+        if (first) {
+            Linux_Free_Block *last = first;
+            while (last->next) {
+                last = last->next;
+            }
+            linux_heap_push_blocks(&linux_heap, size_class, first, last);
+        }
+        cache->free_lists[size_class] = 0;
+        cache->counts[size_class] = 0;
+    }
+    cache->next_unused = linux_heap.unused_caches;
+    linux_heap.unused_caches = cache;
+    spin_unlock(&linux_heap.lock);
+    linux_thread_cache = 0;
+}
+
+function Linux_Thread_Cache *
+linux_get_thread_cache(void) {
+    Linux_Thread_Cache *result = linux_thread_cache;
+    if (!result) {
+        spin_lock(&linux_heap.lock);
+        if (!linux_heap.thread_key_created) {
+            pthread_key_create(&linux_heap.thread_key, linux_thread_cache_exit);
+            linux_heap.thread_key_created = true;
+        }
+        result = linux_heap.unused_caches;
+        if (result) {
+            linux_heap.unused_caches = result->next_unused;
+        } else {
+            // @NOTE: Caches outlive their threads, so they get their own pages.
+            result = (Linux_Thread_Cache *)mmap(0, sizeof(Linux_Thread_Cache), PROT_READ|PROT_WRITE,
+                                                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+            ASSERT(result != MAP_FAILED);
+            result->next = linux_heap.caches;
+            linux_heap.caches = result;
+        }
+        spin_unlock(&linux_heap.lock);
+        pthread_setspecific(linux_heap.thread_key, result);
+        linux_thread_cache = result;
+    }
+    return result;
+}
+
+// @NOTE: Moves up to a batch of blocks from the heap into an empty cache list,
+// carving a new span first if the heap has none.
+function b32
+linux_refill_thread_cache(Linux_Thread_Cache *cache, u32 size_class) {
+    u32 block_size = linux_size_classes[size_class];
+    u32 batch = linux_cache_batch(size_class);
+
+    spin_lock(&linux_heap.lock);
+    if (!linux_heap.free_lists[size_class]) {
+        if (linux_heap.region_at == linux_heap.region_end) {
+            u8 *region = (u8 *)linux_map_aligned(LINUX_REGION_SIZE, LINUX_SPAN_SIZE);
+            if (!region) {
+                spin_unlock(&linux_heap.lock);
+                return false;
+            }
+            linux_heap.region_at  = region;
+            linux_heap.region_end = region + LINUX_REGION_SIZE;
+            atomic_add_u64(&linux_heap.mapped_bytes, LINUX_REGION_SIZE);
+        }
+        Linux_Span *span = (Linux_Span *)linux_heap.region_at;
+        linux_heap.region_at += LINUX_SPAN_SIZE;
+        span->size_class = size_class;
+        span->block_size = block_size;
+        span->heap = &linux_heap;
+
+        // @NOTE: Linked back to front, so the list hands them out in address order.
+        u8 *first = (u8 *)span + LINUX_SPAN_HEADER_SIZE;
+        u32 block_count = (u32)((LINUX_SPAN_SIZE - LINUX_SPAN_HEADER_SIZE) / block_size);
+        Linux_Free_Block *list = linux_heap.free_lists[size_class];
+        for (u32 i = block_count; i > 0; --i) {
+            Linux_Free_Block *block = (Linux_Free_Block *)(first + (umm)(i - 1)*block_size);
+            block->next = list;
+            list = block;
+        }
+        linux_heap.free_lists[size_class] = list;
+    }
+
+    Linux_Free_Block *first = linux_heap.free_lists[size_class];
+    Linux_Free_Block *last = first;
+    u32 count = 1;
+    while (count < batch && last->next) {
+        last = last->next;
+        ++count;
+    }
+    linux_heap.free_lists[size_class] = last->next;
+    spin_unlock(&linux_heap.lock);
+
+    last->next = 0;
+    cache->free_lists[size_class] = first;
+    cache->counts[size_class] = count;
+    return true;
+}
+
+// @NOTE: A block with its own mapping. HUGETLB maps whole huge pages from the
+// pool and falls back to HUGE_PAGES when the pool is short; HUGE_PAGES aligns the
+// mapping to OS_HUGE_PAGE_SIZE so the kernel can back it with them.
+function void *
+linux_alloc_large(umm size, u32 flags, umm *mapped_size) {
+    umm page_size = (umm)sysconf(_SC_PAGESIZE);
+    umm block_size = (size + LINUX_SPAN_HEADER_SIZE + page_size - 1) & ~(page_size - 1);
+    Linux_Span *span = 0;
+
+    if (flags & OS_MEMORY_HUGETLB) {
+        umm huge_size = (size + LINUX_SPAN_HEADER_SIZE + OS_HUGE_PAGE_SIZE - 1) & ~(OS_HUGE_PAGE_SIZE - 1);
+        int populate = (flags & OS_MEMORY_PREFAULT) ? MAP_POPULATE : 0;
+        void *base = mmap(0, huge_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|populate, -1, 0);
+        if (base != MAP_FAILED) {
+            span = (Linux_Span *)base;
+            block_size = huge_size;
+        } else {
+            flags |= OS_MEMORY_HUGE_PAGES;
+        }
+    }
+
+    if (!span) {
+        b32 huge_pages = ((flags & OS_MEMORY_HUGE_PAGES) && block_size >= OS_HUGE_PAGE_SIZE);
+        span = (Linux_Span *)linux_map_aligned(block_size, huge_pages ? OS_HUGE_PAGE_SIZE : LINUX_SPAN_SIZE);
+        if (!span) {
+            return 0;
+        }
+        if (huge_pages) {
+            madvise(span, block_size, MADV_HUGEPAGE);
+        }
+        if (flags & OS_MEMORY_PREFAULT) {
+            linux_prefault(span, block_size);
+        }
+    }
+
+    span->size_class  = LINUX_SIZE_CLASS_LARGE;
+    span->mapped_size = block_size;
+    span->heap        = &linux_heap;
+    atomic_add_u64(&linux_heap.mapped_bytes, block_size);
+    *mapped_size = block_size;
+    void *result = (u8 *)span + LINUX_SPAN_HEADER_SIZE;
+    return result;
+}
+
+// @SPEC: ZII
+function
+OS_ALLOC(linux_alloc) {
+    Linux_Thread_Cache *cache = linux_get_thread_cache();
+    void *result;
+    umm block_size;
+
+    if (size <= LINUX_SMALL_SIZE_MAX) {
+        u32 size_class = linux_size_class(size);
+        if (!cache->free_lists[size_class] && !linux_refill_thread_cache(cache, size_class)) {
+            return 0;
+        }
+        Linux_Free_Block *block = cache->free_lists[size_class];
+        cache->free_lists[size_class] = block->next;
+        --cache->counts[size_class];
+        result = block;
+        block_size = linux_size_classes[size_class];
+        memset(result, 0, size ? size : sizeof(Linux_Free_Block));
+    } else {
+        result = linux_alloc_large(size, 0, &block_size);
+        if (!result) {
+            return 0;
+        }
+    }
+
+    ++cache->alloc_count;
+    cache->live_bytes += block_size;
+    return result;
+}
+
+// @SPEC: ZII
+function
+OS_ALLOC_HINTED(linux_alloc_hinted) {
+    if (!flags || size <= LINUX_SMALL_SIZE_MAX) {
+        return linux_alloc(size);
+    }
+    Linux_Thread_Cache *cache = linux_get_thread_cache();
+    umm block_size;
+    void *result = linux_alloc_large(size, flags, &block_size);
+    if (result) {
+        ++cache->alloc_count;
+        cache->live_bytes += block_size;
+    }
+    return result;
+}
+
+function
+OS_FREE(linux_free) {
+    if (!memory) {
+        return;
+    }
+    Linux_Span *span = (Linux_Span *)((umm)memory & ~(LINUX_SPAN_SIZE - 1));
+    Linux_Heap *heap = span->heap;
+    u32 size_class = span->size_class;
+    b32 large = (size_class == LINUX_SIZE_CLASS_LARGE);
+    umm block_size = large ? span->mapped_size : span->block_size;
+
+    if (large) {
+        ASSERT(memory == (u8 *)span + LINUX_SPAN_HEADER_SIZE);
+        atomic_add_u64(&heap->mapped_bytes, (u64)0 - block_size);
+        munmap(span, block_size);
+    }
+
+    if (heap != &linux_heap) {
+        // @NOTE: The other module's block. Small ones go straight back on its
+        // heap's list, so they're only ever handed out, and counted, by their owner.
+        atomic_add_u64(&heap->remote_free_count, 1);
+        atomic_add_u64(&heap->remote_freed_bytes, block_size);
+        if (!large) {
+            Linux_Free_Block *block = (Linux_Free_Block *)memory;
+            spin_lock(&heap->lock);
+            linux_heap_push_blocks(heap, size_class, block, block);
+            spin_unlock(&heap->lock);
+        }
+        return;
+    }
+
+    Linux_Thread_Cache *cache = linux_get_thread_cache();
+    ++cache->free_count;
+    cache->live_bytes -= block_size;
+    if (large) {
+        return;
+    }
+
+    Linux_Free_Block *block = (Linux_Free_Block *)memory;
+    block->next = cache->free_lists[size_class];
+    cache->free_lists[size_class] = block;
+
+    // @NOTE: Keeps one batch and gives the rest back, so a thread that only
+    // frees doesn't hoard everything.
+    u32 batch = linux_cache_batch(size_class);
+    if (++cache->counts[size_class] >= 2*batch) {
+        Linux_Free_Block *last = block;
+        for (u32 i = 1; i < batch; ++i) {
+            last = last->next;
+        }
+        cache->free_lists[size_class] = last->next;
+        cache->counts[size_class] -= batch;
+
+        spin_lock(&linux_heap.lock);
+        linux_heap_push_blocks(&linux_heap, size_class, block, last);
+        spin_unlock(&linux_heap.lock);
+    }
+}
+
+// @NOTE: HUGETLB reserves without MAP_NORESERVE, so the pool has to cover the
+// whole range up front; a hugetlb range the pool can't back would SIGBUS on first
+// touch instead of failing here.
+function
+OS_RESERVE(linux_reserve) {
+    if ((flags & OS_MEMORY_HUGETLB) && (size & (OS_HUGE_PAGE_SIZE - 1)) == 0) {
+        void *result = mmap(0, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+        if (result != MAP_FAILED) {
+            return result;
+        }
+    }
+    if (flags & (OS_MEMORY_HUGE_PAGES|OS_MEMORY_HUGETLB)) {
+        void *result = linux_map_aligned(size, OS_HUGE_PAGE_SIZE, PROT_NONE, MAP_NORESERVE);
+        if (result) {
+            madvise(result, size, MADV_HUGEPAGE);
+        }
+        return result;
+    }
+
+    void *result = mmap(0, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED) {
+        return 0;
+    }
+    return result;
+}
+
+function
+OS_COMMIT(linux_commit) {
+    b32 result = (mprotect(memory, size, PROT_READ|PROT_WRITE) == 0);
+    if (result && (flags & OS_MEMORY_PREFAULT)) {
+        linux_prefault(memory, size);
+    }
+    return result;
+}
+
+function
+OS_RELEASE(linux_release) {
+    munmap(memory, size);
+}
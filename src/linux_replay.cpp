@@ -0,0 +1,274 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+#include <sys/mman.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+
+#include "core.h"
+#include "intrinsics.h"
+#include "math.h"
+
+#include "platform.h"
+
+Os os;
+
+#include "dst.h"
+
+#include "renderer_atlas.h"
+#include "renderer.h"
+#include "renderer_capture.h"
+#include "renderer_hierarchy.h"
+#include "linux_renderer.h"
+#include "linux_memory.h"
+
+// @NOTE: Replays a capture from renderer_begin_capture() through the renderer .so
+// as fast as it goes, and reports CPU and GPU time per frame.
+//   linux_replay <capture> [renderer.so]
+// CPU time covers renderer_fill_batches() and end_frame, which includes waiting on
+// the previous frame's fence. GPU time comes from the backend's timestamps.
+#define RENDERER_SO "../build/renderer_vulkan.so"
+
+
+function f64
+linux_get_seconds(void) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    f64 result = (f64)ts.tv_sec + (f64)ts.tv_nsec*1e-9;
+    return result;
+}
+
+struct Capture_Reader {
+    u8 *at;
+    u8 *end;
+};
+
+function void *
+capture_read(Capture_Reader *reader, umm size) {
+    ASSERT(reader->at + size <= reader->end);
+    void *result = reader->at;
+    reader->at += size;
+    return result;
+}
+
+template<typename T>
+function void
+capture_read_array(Capture_Reader *reader, Dynamic_Array<T> *array, umm count) {
+    renderer_fit_scratch(array, count);
+    if (count) {
+        copy_array((T *)capture_read(reader, sizeof(T)*count), array->data, count);
+    }
+}
+
+// @NOTE: Puts one captured frame back where end_frame expects it. Pixels are
+// pointed into the capture buffer, which outlives the uploads.
+function Capture_Frame_Header
+replay_load_frame(Capture_Reader *reader) {
+    Capture_Frame_Header header = *(Capture_Frame_Header *)capture_read(reader, sizeof(Capture_Frame_Header));
+
+    g_renderer->has_camera       = header.has_camera;
+    g_renderer->camera           = header.camera;
+    g_renderer->has_view         = header.has_view;
+    g_renderer->cull_rect        = header.cull_rect;
+    g_renderer->gpu_cull_sprites = header.gpu_cull_sprites;
+
+    for (u32 i = 0; i < header.upload_count; ++i) {
+        Capture_Upload record = *(Capture_Upload *)capture_read(reader, sizeof(Capture_Upload));
+        Texture_Upload upload{};
+        upload.kind         = (Texture_Upload_Kind)record.kind;
+        upload.image.id     = record.image_id;
+        upload.image.width  = record.width;
+        upload.image.height = record.height;
+        upload.slot         = record.slot;
+        upload.page         = record.page;
+        upload.x            = record.x;
+        upload.y            = record.y;
+        if (upload.kind != TEXTURE_UPLOAD_ATLAS_PAGE) {
+            upload.image.data = (u8 *)capture_read(reader, 4*record.width*record.height);
+        }
+        g_renderer->image_create_queue.push(upload);
+    }
+
+    for (u32 i = 0; i < header.destroy_count; ++i) {
+        g_renderer->image_destroy_queue.push(*(u32 *)capture_read(reader, sizeof(u32)));
+    }
+
+    for (u32 i = 0; i < header.static_batch_count; ++i) {
+        Capture_Static_Batch record = *(Capture_Static_Batch *)capture_read(reader, sizeof(Capture_Static_Batch));
+        ASSERT(record.id > 0 && record.id <= RENDERER_STATIC_BATCH_COUNT);
+        Static_Batch_Data *data = g_renderer->static_batches + record.id - 1;
+        data->used   = record.used;
+        data->opaque = record.opaque;
+        data->bounds = record.bounds;
+        capture_read_array(reader, &data->vertices, record.vertex_count);
+        ++data->generation;
+        g_renderer->static_batch_count = MAX(g_renderer->static_batch_count, record.id);
+    }
+
+    g_renderer->clip_count      = header.clip_count;
+    g_renderer->clip_mask_count = header.clip_mask_count;
+    if (header.clip_count) {
+        copy_array((Renderer_Clip *)capture_read(reader, sizeof(Renderer_Clip)*header.clip_count),
+                   g_renderer->clips, header.clip_count);
+    }
+    capture_read_array(reader, &g_renderer->clip_mask_vertices, header.clip_mask_vertex_count);
+
+    Draw_List *list = g_renderer->draw_lists;
+    capture_read_array(reader, &list->sort_keys, header.triangle_count);
+    capture_read_array(reader, &list->vertices, 3*header.triangle_count);
+    capture_read_array(reader, &list->quad_sort_keys, header.quad_count);
+    capture_read_array(reader, &list->quad_vertices, 4*header.quad_count);
+    capture_read_array(reader, &list->compact_quad_sort_keys, header.compact_quad_count);
+    capture_read_array(reader, &list->compact_quad_vertices, 4*header.compact_quad_count);
+    capture_read_array(reader, &list->sprite_sort_keys, header.sprite_count);
+    capture_read_array(reader, &list->sprites, header.sprite_count);
+    capture_read_array(reader, &list->static_sort_keys, header.static_draw_count);
+    capture_read_array(reader, &list->static_draws, header.static_draw_count);
+
+    return header;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <capture> [renderer.so]\n", argv[0]);
+        return 1;
+    }
+    const char *renderer_so_filepath = (argc > 2) ? argv[2] : RENDERER_SO;
+
+    Buffer file = read_entire_file(argv[1]);
+    if (!file.data || file.size < sizeof(Capture_File_Header)) {
+        return 1;
+    }
+    Capture_File_Header *file_header = (Capture_File_Header *)file.data;
+    if (file_header->magic != RENDERER_CAPTURE_MAGIC || file_header->version != RENDERER_CAPTURE_VERSION) {
+        fprintf(stderr, "[ERROR] %s isn't a version %u capture.\n", argv[1], RENDERER_CAPTURE_VERSION);
+        return 1;
+    }
+    u32 frame_count = file_header->frame_count;
+    if (frame_count == 0) {
+        return 0;
+    }
+
+    Capture_Reader reader{};
+    reader.at  = file.data + sizeof(Capture_File_Header);
+    reader.end = file.data + file.size;
+
+    // @NOTE: Window starts at the first frame's extent; it's peeked here and read
+    // again by replay_load_frame().
+    Capture_Frame_Header first = *(Capture_Frame_Header *)reader.at;
+
+    Display *display = XOpenDisplay(NULL);
+    if (!display) {
+        INVALID_CODE_PATH;
+    }
+
+    Window window = XCreateSimpleWindow(display, XDefaultRootWindow(display), 0, 0, first.width, first.height, 0, 0, 0);
+
+    XMapWindow(display, window);
+    XSync(display, False);
+
+
+    Linux_Renderer_Function_Table renderer_function_table{};
+
+    void *renderer_so = dlopen(renderer_so_filepath, RTLD_NOW | RTLD_LOCAL);
+    if (!renderer_so) {
+        fprintf(stderr, "dlopen failed: %s\n", dlerror());
+        INVALID_CODE_PATH;
+    }
+    for (u32 i = 0; i < arraycount(linux_renderer_function_table_names); ++i) {
+        ((void **)&renderer_function_table)[i] = dlsym(renderer_so, linux_renderer_function_table_names[i]);
+        if (!((void **)&renderer_function_table)[i]) {
+            fprintf(stderr, "dlsym failed: %s\n", dlerror());
+            INVALID_CODE_PATH;
+        }
+    }
+
+    g_renderer = renderer_function_table.load_renderer(display, window);
+
+    os.alloc        = linux_alloc;
+    os.alloc_hinted = linux_alloc_hinted;
+    os.free         = linux_free;
+    os.alloc_stats  = linux_alloc_stats;
+    os.reserve      = linux_reserve;
+    os.commit       = linux_commit;
+    os.release      = linux_release;
+
+    f64 *cpu_ms = (f64 *)os.alloc(sizeof(f64)*frame_count);
+    f64 *gpu_ms = (f64 *)os.alloc(sizeof(f64)*frame_count);
+    u32 *draw_counts  = (u32 *)os.alloc(sizeof(u32)*frame_count);
+    u32 *batch_counts = (u32 *)os.alloc(sizeof(u32)*frame_count);
+    u32 *call_counts  = (u32 *)os.alloc(sizeof(u32)*frame_count);
+    u32 width  = first.width;
+    u32 height = first.height;
+
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        while (XPending(display)) {
+            XEvent event{};
+            XNextEvent(display, &event);
+        }
+
+        Capture_Frame_Header header = replay_load_frame(&reader);
+        if (header.width != width || header.height != height) {
+            XResizeWindow(display, window, header.width, header.height);
+            XSync(display, False);
+            width  = header.width;
+            height = header.height;
+        }
+        draw_counts[frame] = (header.triangle_count + header.quad_count + header.compact_quad_count +
+                              header.sprite_count + header.static_draw_count);
+
+        f64 begin = linux_get_seconds();
+        renderer_fill_batches();
+        batch_counts[frame] = (u32)g_renderer->batches.count;
+        renderer_function_table.end_frame();
+        cpu_ms[frame] = (linux_get_seconds() - begin)*1000.0;
+        call_counts[frame] = g_renderer->draw_call_count;
+
+        // @NOTE: end_frame reports the GPU time of the frame before it.
+        if (frame > 0) {
+            gpu_ms[frame - 1] = g_renderer->gpu_frame_ms;
+        }
+    }
+
+    // One empty frame to collect the last frame's GPU time.
+    renderer_function_table.end_frame();
+    gpu_ms[frame_count - 1] = g_renderer->gpu_frame_ms;
+
+    printf("%8s %10s %10s %10s %10s %10s\n", "frame", "cpu ms", "gpu ms", "draws", "batches", "calls");
+    f64 cpu_total = 0, gpu_total = 0;
+    f64 cpu_max = 0, gpu_max = 0;
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        printf("%8u %10.3f %10.3f %10u %10u %10u\n", frame, cpu_ms[frame], gpu_ms[frame],
+               draw_counts[frame], batch_counts[frame], call_counts[frame]);
+        cpu_total += cpu_ms[frame];
+        gpu_total += gpu_ms[frame];
+        cpu_max = MAX(cpu_max, cpu_ms[frame]);
+        gpu_max = MAX(gpu_max, gpu_ms[frame]);
+    }
+    printf("== %u frames: cpu avg %.3f max %.3f ms, gpu avg %.3f max %.3f ms ==\n", frame_count,
+           cpu_total / frame_count, cpu_max, gpu_total / frame_count, gpu_max);
+    if (g_renderer->gpu_cull_stats.tested) {
+        printf("== gpu cull, last frame: %u sprites tested, %u culled ==\n",
+               g_renderer->gpu_cull_stats.tested, g_renderer->gpu_cull_stats.culled);
+    }
+
+    return 0;
+}
@@ -14,6 +14,8 @@
     
 
 #include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
@@ -30,27 +32,17 @@
 
 Os os;
 
+#include "renderer_atlas.h"
 #include "renderer.h"
+#include "renderer_capture.h"
+#include "renderer_hierarchy.h"
 global Renderer renderer;
 
 #include "linux_renderer.h"
+#include "linux_memory.h"
 #include "renderer_vulkan.cpp"
 
 
-// @SPEC: ZII
-function void *
-linux_alloc(size_t size) {
-    void *result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-    return result;
-}
-
-function void
-linux_free(void *memory) {
-    if (memory) {
-        // @TODO:
-    }
-}
-
 function void
 linux_vk_create_instance(Vulkan *vk, const char **layers, u32 layer_count) {
     VkApplicationInfo app_info{};
@@ -106,8 +98,8 @@ linux_vk_pick_physical_device_and_create_surface(Vulkan *vk, Display *display, W
         u32 queue_family_property_count;
         VkQueueFamilyProperties *queue_family_properties;
         vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_property_count, 0);
-        queue_family_properties = (VkQueueFamilyProperties *)os.alloc(sizeof(queue_family_properties) * queue_family_property_count);
-        SCOPE_EXIT(os.free(queue_family_properties));
+        TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+        queue_family_properties = push_array(&renderer.frame_arena, VkQueueFamilyProperties, queue_family_property_count);
         vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_property_count, queue_family_properties);
 
         Vk_Queue_Family graphics_queue_family{};
@@ -160,8 +152,8 @@ linux_vk_pick_physical_device_and_create_surface(Vulkan *vk, Display *display, W
 function void
 linux_vk_pick_best_physical_device_and_create_surface(Vulkan *vk, Display *display, Window window) {
     u32 physical_device_count = vk_query_physical_device_count(vk->instance);
-    VkPhysicalDevice *physical_devices = (VkPhysicalDevice *)linux_alloc(sizeof(VkPhysicalDevice)*physical_device_count);
-    SCOPE_EXIT(linux_free(physical_devices));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkPhysicalDevice *physical_devices = push_array(&renderer.frame_arena, VkPhysicalDevice, physical_device_count);
     vk_query_physical_devices(vk->instance, physical_devices);
     vk_sort_physical_devices(physical_devices, physical_device_count);
     ASSERT(linux_vk_pick_physical_device_and_create_surface(vk, display, window, physical_devices, physical_device_count));
@@ -185,18 +177,27 @@ RENDERER_END_FRAME(linux_end_frame) {
             vk_recreate_swapchain(vk, width, height);
         }
 
+        renderer_capture_frame(width, height);
         vk_draw(vk);
     }
 
-    renderer.sort_keys.clear();
-    renderer.vertices.clear();
-    renderer.drawcall_vertex_count.clear();
+    arena_reset(&renderer.frame_arena);
+
+    // @NOTE: renderer_sort() already merged and cleared the other lists.
+    renderer_clear_draw_list(renderer.draw_lists);
+    renderer.batches.clear();
+    renderer_clear_clips();
 }
 
 extern "C"
 LINUX_LOAD_RENDERER(linux_load_renderer) {
-    os.alloc = linux_alloc;
-    os.free  = linux_free;
+    os.alloc        = linux_alloc;
+    os.alloc_hinted = linux_alloc_hinted;
+    os.free         = linux_free;
+    os.alloc_stats  = linux_alloc_stats;
+    os.reserve      = linux_reserve;
+    os.commit       = linux_commit;
+    os.release      = linux_release;
 
     renderer.platform = linux_alloc(sizeof(Renderer_Linux));
     Renderer_Linux *renderer_linux = (Renderer_Linux *)renderer.platform;
@@ -207,6 +208,7 @@ LINUX_LOAD_RENDERER(linux_load_renderer) {
     Vulkan *vk = (Vulkan *)renderer.backend;
 
     renderer.image_hash_table.init(32);
+    renderer_set_memory_hints(&renderer);
 
 
     const char *desired_layers[] = {
@@ -216,8 +218,8 @@ LINUX_LOAD_RENDERER(linux_load_renderer) {
 #endif
     };
     u32 available_layer_count = vk_query_available_layer_count();
-    VkLayerProperties *available_layers = (VkLayerProperties *)linux_alloc(sizeof(VkLayerProperties) * available_layer_count);
-    SCOPE_EXIT(linux_free(available_layers));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkLayerProperties *available_layers = push_array(&renderer.frame_arena, VkLayerProperties, available_layer_count);
     vk_query_available_layers(available_layers);
     for (u32 i = 0; i < arraycount(desired_layers); ++i) {
         if (!vk_is_layer_available(desired_layers[i], available_layers, available_layer_count)) {
@@ -1127,6 +1127,28 @@ in_rect(Rect2 rect, v2 p)
     return result;
 }
 
+function b32
+overlaps(Rect2 a, Rect2 b)
+{
+    b32 result = (a.min.x < b.max.x &&
+                  a.min.y < b.max.y &&
+                  b.min.x < a.max.x &&
+                  b.min.y < a.max.y);
+    return result;
+}
+
+// @NOTE: Empty (min past max) when they don't overlap.
+function Rect2
+intersect(Rect2 a, Rect2 b)
+{
+    Rect2 result = {};
+    result.min.x = MAX(a.min.x, b.min.x);
+    result.min.y = MAX(a.min.y, b.min.y);
+    result.max.x = MIN(a.max.x, b.max.x);
+    result.max.y = MIN(a.max.y, b.max.y);
+    return result;
+}
+
 function v2
 get_dim(Rect2 rect)
 {
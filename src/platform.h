@@ -10,14 +10,66 @@
 
 
 
+// @NOTE: Backing hints for big, hot memory. They only change how pages are
+// backed and when they're faulted in; a hint the system can't take is dropped.
+//   HUGE_PAGES: transparent huge pages, where the kernel allows them.
+//   HUGETLB:    explicit huge pages from the reserved pool; without enough of
+//               them it falls back to HUGE_PAGES.
+//   PREFAULT:   faults the pages in up front instead of on first touch.
+enum Os_Memory_Flags {
+    OS_MEMORY_HUGE_PAGES    = 0x1,
+    OS_MEMORY_HUGETLB       = 0x2,
+    OS_MEMORY_PREFAULT      = 0x4,
+};
+
+// @NOTE: x86-64's default huge page, which is what both hints get.
+#define OS_HUGE_PAGE_SIZE ((umm)2 << 20)
+
 #define OS_ALLOC(NAME) void *NAME(size_t size)
 typedef OS_ALLOC(Os_Alloc);
 
+// @NOTE: os.alloc with Os_Memory_Flags. Hints only apply to blocks big enough to
+// get their own pages; alloc_hinted(size, 0) is alloc(size).
+#define OS_ALLOC_HINTED(NAME) void *NAME(size_t size, u32 flags)
+typedef OS_ALLOC_HINTED(Os_Alloc_Hinted);
+
 #define OS_FREE(NAME) void NAME(void *memory)
 typedef OS_FREE(Os_Free);
 
+// @NOTE: Counters for the blocks this module allocated, whichever module frees
+// them; the exe and the renderer .so each keep their own. Bytes are what the allocator hands out (whole size classes
+// or pages), and mapped is what it holds from the OS for that.
+struct Os_Alloc_Stats {
+    u64 alloc_count;
+    u64 free_count;
+    s64 live_bytes;
+    u64 mapped_bytes;
+};
+
+#define OS_ALLOC_STATS(NAME) Os_Alloc_Stats NAME(void)
+typedef OS_ALLOC_STATS(Os_Alloc_Stats_Function);
+
+// @NOTE: Address space without memory behind it, for arenas to commit into as
+// they grow. Committed pages are zero. release takes the size reserve got.
+// Both take the same Os_Memory_Flags; with either huge page hint, commit in
+// whole OS_HUGE_PAGE_SIZE steps.
+#define OS_RESERVE(NAME) void *NAME(size_t size, u32 flags)
+typedef OS_RESERVE(Os_Reserve);
+
+#define OS_COMMIT(NAME) b32 NAME(void *memory, size_t size, u32 flags)
+typedef OS_COMMIT(Os_Commit);
+
+#define OS_RELEASE(NAME) void NAME(void *memory, size_t size)
+typedef OS_RELEASE(Os_Release);
+
 struct Os {
     // @SPEC: allocation must be initted to zero.
     Os_Alloc    *alloc;
+    Os_Alloc_Hinted *alloc_hinted;
     Os_Free     *free;
+    Os_Alloc_Stats_Function *alloc_stats;
+
+    Os_Reserve  *reserve;
+    Os_Commit   *commit;
+    Os_Release  *release;
 };
@@ -13,16 +13,25 @@
 typedef RENDERER_END_FRAME(Renderer_End_Frame);
 
 
+// @NOTE: Whether an image has any alpha below 1. DETECT (the zero value) scans data
+// when the image is registered; tag it to skip the scan.
+enum Image_Alpha {
+    IMAGE_ALPHA_DETECT = 0,
+    IMAGE_ALPHA_OPAQUE,
+    IMAGE_ALPHA_TRANSLUCENT,
+};
+
 struct Image {
     u32 id;
     u8 *data;
     u32 width;
     u32 height;
+    Image_Alpha alpha;
 };
 
 function umm
 hash(Image image) {
-    return image.id;
+    return hash(image.id);
 }
 
 function b32
@@ -30,118 +39,1797 @@ operator == (Image a, Image b) {
     return a.id == b.id;
 }
 
+// @NOTE: Every image gets a slot in the backend's bindless texture array, and
+// draws carry the slot per vertex or per instance, so a texture change doesn't
+// break a batch. Slot 0 is the backend's default texture, used by untextured draws.
+#define RENDERER_TEXTURE_SLOT_COUNT 1024
+
 struct Vertex {
     v2 position;
     v4 color;
     v2 uv;
+    u32 texture;        // bindless slot
+};
+
+// @NOTE: Vertex quantized for 2D: color as RGBA8 and uv as unorm16, 20 bytes.
+// Only usable when color and uv are in [0, 1]; see vertex_fits_compact().
+struct Vertex_Compact {
+    v2 position;
+    u32 color;          // RGBA8, R in the low byte
+    u16 uv[2];          // unorm16
+    u32 texture;        // bindless slot
+};
+static_assert(sizeof(Vertex_Compact) == 20, "Vertex_Compact should stay 20 bytes.");
+
+// @NOTE: One per sprite in instanced mode; the vertex shader expands the corners.
+// 32 bytes vs. 6*sizeof(Vertex) = 192 for the same quad as triangles.
+struct Sprite_Instance {
+    v2 center;
+    v2 half_dim;
+    u16 uv_min[2];      // unorm16
+    u16 uv_max[2];      // unorm16
+    u32 color;          // RGBA8, R in the low byte
+    u16 texture;        // bindless slot
+    u16 rotation;       // unorm16 turns, 0x10000 = 2*pi
+};
+static_assert(sizeof(Sprite_Instance) == 32, "Sprite_Instance should stay 32 bytes.");
+
+enum Renderer_Pipeline {
+    RENDERER_PIPELINE_SIMPLE = 0,
+    RENDERER_PIPELINE_SIMPLE_COMPACT,
+    RENDERER_PIPELINE_SPRITE,
+
+    RENDERER_PIPELINE_COUNT,
 };
 
+// @NOTE: Bit widths of the packed sort key, high to low:
+//   opaque:      [0][~layer][pipeline][clip][texture][depth]
+//   translucent: [1][layer][depth][pipeline][clip][texture]
+// Every opaque draw comes first, front to back (top layer first) and grouped by
+// state, with depth writes on, so early-Z rejects what's hidden behind them.
+// Translucent draws follow back to front in painter's order, depth tested
+// against the opaque ones. Override any of these before including this file.
+#ifndef SORT_KEY_LAYER_BITS
+#  define SORT_KEY_LAYER_BITS       8
+#endif
+#ifndef SORT_KEY_PIPELINE_BITS
+#  define SORT_KEY_PIPELINE_BITS    7
+#endif
+#ifndef SORT_KEY_CLIP_BITS
+#  define SORT_KEY_CLIP_BITS        8
+#endif
+#ifndef SORT_KEY_TEXTURE_BITS
+#  define SORT_KEY_TEXTURE_BITS     16
+#endif
+#ifndef SORT_KEY_DEPTH_BITS
+#  define SORT_KEY_DEPTH_BITS       24
+#endif
+static_assert(SORT_KEY_LAYER_BITS + 1 + SORT_KEY_PIPELINE_BITS + SORT_KEY_CLIP_BITS +
+              SORT_KEY_TEXTURE_BITS + SORT_KEY_DEPTH_BITS <= 64,
+              "Sort key fields don't fit in 64 bits.");
+static_assert(RENDERER_PIPELINE_COUNT <= (1 << SORT_KEY_PIPELINE_BITS), "Not enough pipeline bits.");
+static_assert(RENDERER_TEXTURE_SLOT_COUNT <= (1 << SORT_KEY_TEXTURE_BITS), "Not enough texture bits.");
+
 struct Sort_Key {
-    u32 image_id;
+    u32 layer;
+    b32 translucent;
+    u32 pipeline;
+    u32 clip;           // 0 = unclipped, else index + 1 into Renderer::clips
+    u32 texture;        // bindless slot
+    u32 depth;
+};
+
+// @NOTE: What the radix sort actually moves around: packed key + primitive index.
+struct Sort_Entry {
+    u64 key;
+    u32 index;
+};
+
+enum Render_Batch_Kind {
+    RENDER_BATCH_TRIANGLES,
+    RENDER_BATCH_QUADS,
+    RENDER_BATCH_COMPACT_QUADS,
+    RENDER_BATCH_SPRITES,
+    RENDER_BATCH_STATIC,
+    RENDER_BATCH_KIND_COUNT,
+};
+
+// @NOTE: Quads are 4 vertices each, drawn against a static index pattern
+// (0,1,2, 2,1,3, then +4 per quad) of u16 indices. A batch longer than this is
+// split across draws.
+#define RENDERER_QUADS_PER_DRAW (65536 / 4)
+
+// @NOTE: A run of primitives from one stream that share GPU state.
+// first/count are in vertices for triangles and quads, and in instances for sprites.
+// A static batch draw is always its own batch: first is the Static_Batch id and
+// count its vertex count.
+struct Render_Batch {
+    u64 key;
+    Sort_Key sort_key;
+    Render_Batch_Kind kind;
+    u32 first;
+    u32 count;
+};
+
+// @NOTE: Images with both sides at or under this are packed into shared atlas
+// pages instead of getting their own VkImage and slot. Their UVs are rewritten into
+// the page, so they can't tile with uv outside [0, 1].
+#define RENDERER_ATLAS_MAX_IMAGE_DIM    128
+#define RENDERER_ATLAS_PAGE_COUNT       8
+// @NOTE: Extruded border around each atlas image so linear filtering at its edge
+// doesn't pick up its neighbours.
+#define RENDERER_ATLAS_PADDING          1
+
+// @NOTE: Where an image ended up: its slot and the part of that slot it covers.
+struct Texture_Region {
+    u32 slot;
+    v2 uv_min;
+    v2 uv_max;
+    b32 in_atlas;
+    b32 opaque;
+};
+
+enum Texture_Upload_Kind {
+    TEXTURE_UPLOAD_IMAGE,           // Own image at slot.
+    TEXTURE_UPLOAD_ATLAS_PAGE,      // Empty ATLAS_PAGE_DIM^2 page at slot.
+    TEXTURE_UPLOAD_ATLAS_REGION,    // image copied into page at (x, y), padding included.
+};
+
+struct Texture_Upload {
+    Texture_Upload_Kind kind;
+    Image image;
+    u32 slot;
+    u32 page;
+    u32 x;
+    u32 y;
+};
+
+// @NOTE: Geometry that's built once and drawn by handle every frame. The vertices
+// are quads in the full Vertex layout, kept in submission order; the backend keeps
+// a device-local copy and only re-uploads it when generation changes, which
+// end_static_batch() and destroy_static_batch() do. Id 0 is no batch.
+#define RENDERER_STATIC_BATCH_COUNT 256
+
+struct Static_Batch {
+    u32 id;
+};
+
+struct Static_Batch_Data {
+    b32 used;
+    u32 generation;
+    Rect2 bounds;
+    b32 opaque;         // Every draw in it was opaque.
+    Dynamic_Array<Vertex> vertices;
+};
+
+// @NOTE: Draws that reached the visibility test, and how many of those it dropped.
+struct Renderer_Cull_Stats {
+    u32 tested;
+    u32 culled;
+};
+
+// @NOTE: Clips are screen space, the same space as the view rect and, without a
+// camera, the same as world space. A clip's rect is already intersected with its
+// parents' and goes to vkCmdSetScissor. Masks clip to the union of some triangles
+// instead: each gets one stencil bit, so at most RENDERER_CLIP_MASK_COUNT masks
+// per frame, and a draw passes where every bit in stencil_bits is set, which
+// makes nested masks intersect. Ids live for one frame; renderer_clear_clips()
+// at end of frame recycles them.
+#define RENDERER_CLIP_COUNT         ((1 << SORT_KEY_CLIP_BITS) - 1)
+#define RENDERER_CLIP_MASK_COUNT    8
+#define RENDERER_CLIP_STACK_DEPTH   32
+
+struct Renderer_Clip {
+    Rect2 rect;
+    Rect2 world_bounds;         // rect taken back through the camera, for culling
+    u32 stencil_bits;           // Masks this clip and its parents need.
+    u32 mask_bit;               // Bit this clip's own mask writes, 0 if it's a rect.
+    u32 first_mask_vertex;      // Into Renderer::clip_mask_vertices, 3 per triangle.
+    u32 mask_vertex_count;
+};
+
+enum Renderer_Simd {
+    RENDERER_SIMD_DETECT = 0,
+    RENDERER_SIMD_SCALAR,
+    RENDERER_SIMD_SSE2,
+    RENDERER_SIMD_AVX2,
+};
+
+// @NOTE: Everything one thread pushes in a frame. Threads each bind their own list
+// (renderer_begin_draw_list), so pushing takes no locks; lists are merged into
+// draw_lists[0] by renderer_sort(). Each list starts on its own cache line so
+// threads bumping neighbouring counts don't false-share.
+#define RENDERER_DRAW_LIST_COUNT 16
+#define RENDERER_CACHE_LINE_SIZE 64
+
+struct alignas(RENDERER_CACHE_LINE_SIZE) Draw_List {
+    // @NOTE: Stamped onto every draw. depth defaults to submission order.
+    u32 layer;
+    b32 translucent;
+    u32 sort_sequence;
+
+    // @NOTE: Last image registered through this list, so runs of the same image
+    // skip the shared image table and its lock.
+    b32 has_cached_image;
+    Image cached_image;
+    Texture_Region cached_region;
+
+    Dynamic_Array<Sort_Key>         sort_keys;
+    Dynamic_Array<Vertex>           vertices;
+
+    Dynamic_Array<Sort_Key>         quad_sort_keys;
+    Dynamic_Array<Vertex>           quad_vertices;
+
+    Dynamic_Array<Sort_Key>         compact_quad_sort_keys;
+    Dynamic_Array<Vertex_Compact>   compact_quad_vertices;
+
+    Dynamic_Array<Sort_Key>         sprite_sort_keys;
+    Dynamic_Array<Sprite_Instance>  sprites;
+
+    Dynamic_Array<Sort_Key>         static_sort_keys;
+    Dynamic_Array<Static_Batch>     static_draws;
+
+    // @NOTE: Set between begin_static_batch() and end_static_batch(); draws go
+    // into it instead of the streams above.
+    Static_Batch_Data *recording;
+
+    Renderer_Cull_Stats cull_stats;
+
+    // @NOTE: Clip ids from push_clip_rect()/push_clip_mask(); the top one is
+    // stamped onto every draw.
+    u32 clip_stack[RENDERER_CLIP_STACK_DEPTH];
+    u32 clip_depth;
+};
+
+// @NOTE: See renderer_capture.h. static_generations is the generation of each
+// static batch as of the last captured frame, so unchanged batches aren't rewritten.
+struct Renderer_Capture {
+    FILE *file;
+    u32 frames_left;
+    u32 frame_count;
+    u32 static_generations[RENDERER_STATIC_BATCH_COUNT];
 };
 
 struct Renderer {
     void *platform;
     void *backend;
 
-    Hash_Table<Image, int> image_hash_table;
-    Queue<Image> image_create_queue;
+    // @NOTE: Written by the backend: GPU time of the latest frame that finished,
+    // from timestamp queries. 0 where the device can't timestamp.
+    f32 gpu_frame_ms;
+    // @NOTE: Written by the backend: draw commands it recorded for the last frame.
+    u32 draw_call_count;
+
+    Renderer_Capture capture;
+
+    // @NOTE: Scratch that lives until the end of the frame: the platform layer
+    // resets it after the backend has drawn. Backend thread only.
+    Memory_Arena frame_arena;
+
+    // @NOTE: Image -> bindless slot and atlas placement. Both are decided here so
+    // draws can use them right away; the backend uploads and fills descriptors later.
+    // Everything down to atlas_page_count is guarded by image_lock.
+    volatile u32 image_lock;
+    Hash_Table<Image, Texture_Region> image_hash_table;
+    Chunked_Queue<Texture_Upload> image_create_queue;
+    Chunked_Queue<u32> image_destroy_queue;
+    Dynamic_Array<u32> texture_slot_free_list;
+    u32 texture_slot_count;
+    Atlas_Page atlas_pages[RENDERER_ATLAS_PAGE_COUNT];
+    u32 atlas_page_count;
 
-    Dynamic_Array<Sort_Key>     sort_keys;
-    Dynamic_Array<Vertex>       vertices;
-    Dynamic_Array<u32>          drawcall_vertex_count;
+    // @NOTE: draw_textured_quad() goes through the sprite stream instead of triangles.
+    b32 instanced_sprites;
+
+    // @NOTE: Sprites skip the cull test at push time and the backend culls them
+    // in a compute pass instead, against cull_rect and their batch's clip. Only
+    // takes effect where the backend set gpu_cull_supported. gpu_cull_stats is
+    // written by the backend, for the latest frame that finished.
+    b32 gpu_cull_sprites;
+    b32 gpu_cull_supported;
+    Renderer_Cull_Stats gpu_cull_stats;
+
+    // @NOTE: Kernel draw_textured_quads() expands with. Left at DETECT, the first
+    // call picks the widest one the CPU has; set it to force one.
+    Renderer_Simd simd;
+
+    // @NOTE: With a view set, draws whose bounds miss cull_rect are dropped at push
+    // time. view_rect is in screen space; cull_rect is its bounds in world space,
+    // taken back through the camera. camera maps world to screen, and the backend
+    // applies it; without one, world is screen.
+    b32 has_view;
+    Rect2 view_rect;
+    Rect2 cull_rect;
+    b32 has_camera;
+    v2 camera_center;
+    f32 camera_rotation;
+    f32 camera_zoom;
+    m4x4 camera;
+
+    // @NOTE: Indexed by clip id - 1, shared by every draw list and guarded by
+    // clip_lock. Mask triangles are world space, ready to draw.
+    volatile u32 clip_lock;
+    Renderer_Clip clips[RENDERER_CLIP_COUNT];
+    u32 clip_count;
+    u32 clip_mask_count;
+    Dynamic_Array<Vertex> clip_mask_vertices;
+
+    // @NOTE: Indexed by id - 1. Create and destroy from the main thread only.
+    Static_Batch_Data static_batches[RENDERER_STATIC_BATCH_COUNT];
+    Dynamic_Array<u32> static_batch_free_list;
+    u32 static_batch_count;
+
+    // @NOTE: [0] is the main thread's, and after renderer_sort() it holds the whole
+    // frame, sorted. That's what batches and the backend read.
+    Draw_List draw_lists[RENDERER_DRAW_LIST_COUNT];
+
+    Dynamic_Array<Render_Batch>     batches;
+
+    // @NOTE: Scratch for renderer_sort(), kept around so we don't allocate every frame.
+    Dynamic_Array<Sort_Entry>       sort_entries;
+    Dynamic_Array<Sort_Entry>       sort_entries_scratch;
+    Dynamic_Array<Sort_Key>         sort_keys_scratch;
+    Dynamic_Array<Vertex>           vertices_scratch;
+    Dynamic_Array<Vertex>           quad_vertices_scratch;
+    Dynamic_Array<Vertex_Compact>   compact_quad_vertices_scratch;
+    Dynamic_Array<Sprite_Instance>  sprites_scratch;
+    Dynamic_Array<Static_Batch>     static_draws_scratch;
+    Dynamic_Array<Render_Batch>     batches_scratch;
 };
 
 global Renderer *g_renderer;
+thread_local Draw_List *tl_draw_list;
+
+// @NOTE: Binds draw list index to the calling thread until renderer_end_draw_list().
+// Index 0 is the main thread's; no two threads may use the same list at once.
+function void
+renderer_begin_draw_list(u32 index) {
+    ASSERT(index < RENDERER_DRAW_LIST_COUNT);
+    tl_draw_list = g_renderer->draw_lists + index;
+}
+
+function void
+renderer_end_draw_list(void) {
+    tl_draw_list = 0;
+}
+
+function Draw_List *
+renderer_draw_list(void) {
+    Draw_List *result = tl_draw_list;
+    if (!result) {
+        result = g_renderer->draw_lists;
+    }
+    return result;
+}
+
+// @NOTE: The streams and their sort scratch reach tens of MB a frame. Huge pages
+// cut their TLB misses, and prefaulting moves the page faults into the grow
+// instead of the pushes after it. Called by the backend on load.
+#define RENDERER_STREAM_MEMORY_FLAGS (OS_MEMORY_HUGE_PAGES|OS_MEMORY_PREFAULT)
+
+function void
+renderer_set_memory_hints(Renderer *r) {
+    u32 flags = RENDERER_STREAM_MEMORY_FLAGS;
+    for (u32 i = 0; i < RENDERER_DRAW_LIST_COUNT; ++i) {
+        Draw_List *list = r->draw_lists + i;
+        list->sort_keys.memory_flags              = flags;
+        list->vertices.memory_flags               = flags;
+        list->quad_sort_keys.memory_flags         = flags;
+        list->quad_vertices.memory_flags          = flags;
+        list->compact_quad_sort_keys.memory_flags = flags;
+        list->compact_quad_vertices.memory_flags  = flags;
+        list->sprite_sort_keys.memory_flags       = flags;
+        list->sprites.memory_flags                = flags;
+    }
+    r->sort_entries.memory_flags                  = flags;
+    r->sort_entries_scratch.memory_flags          = flags;
+    r->sort_keys_scratch.memory_flags             = flags;
+    r->vertices_scratch.memory_flags              = flags;
+    r->quad_vertices_scratch.memory_flags         = flags;
+    r->compact_quad_vertices_scratch.memory_flags = flags;
+    r->sprites_scratch.memory_flags               = flags;
+}
+
+function void
+renderer_clear_draw_list(Draw_List *list) {
+    list->sort_keys.clear();
+    list->vertices.clear();
+    list->quad_sort_keys.clear();
+    list->quad_vertices.clear();
+    list->compact_quad_sort_keys.clear();
+    list->compact_quad_vertices.clear();
+    list->sprite_sort_keys.clear();
+    list->sprites.clear();
+    list->static_sort_keys.clear();
+    list->static_draws.clear();
+    list->sort_sequence = 0;
+    list->cull_stats = {};
+    list->clip_depth = 0;
+}
+
+function void
+set_layer(u32 layer, b32 translucent) {
+    ASSERT(layer < (1 << SORT_KEY_LAYER_BITS));
+    Draw_List *list = renderer_draw_list();
+    list->layer       = layer;
+    list->translucent = translucent;
+}
+
+function u32
+renderer_current_clip(Draw_List *list) {
+    u32 result = list->clip_depth ? list->clip_stack[list->clip_depth - 1] : 0;
+    return result;
+}
+
+// @NOTE: opaque is whether the draw itself covers every pixel it touches; a
+// translucent layer blends it anyway.
+function Sort_Key
+make_sort_key(u32 pipeline, u32 texture, b32 opaque) {
+    Draw_List *list = renderer_draw_list();
+    Sort_Key result{};
+    result.layer        = list->layer;
+    result.translucent  = list->translucent || !opaque;
+    result.pipeline     = pipeline;
+    result.clip         = renderer_current_clip(list);
+    result.texture      = texture;
+    result.depth        = list->sort_sequence++;
+    return result;
+}
+
+// @NOTE: Inverse of the camera: screen = zoom*rotate(world - center, -rotation) + view_center.
+function v2
+renderer_screen_to_world(v2 screen) {
+    if (!g_renderer->has_camera) {
+        return screen;
+    }
+
+    Rect2 view = g_renderer->view_rect;
+    v2 view_center = 0.5f*(view.min + view.max);
+    f32 c = cos(g_renderer->camera_rotation);
+    f32 s = sin(g_renderer->camera_rotation);
+    v2 p = (1.0f / g_renderer->camera_zoom)*(screen - view_center);
+    v2 result = g_renderer->camera_center + v2{c*p.x - s*p.y, s*p.x + c*p.y};
+    return result;
+}
+
+// @NOTE: Conservative when the camera is rotated: the corners are taken to world
+// space and bounded.
+function Rect2
+renderer_screen_to_world_bounds(Rect2 screen) {
+    v2 corners[4] = {screen.min, v2{screen.max.x, screen.min.y}, v2{screen.min.x, screen.max.y}, screen.max};
+    Rect2 result = rect2_inv_inf();
+    for (u32 i = 0; i < 4; ++i) {
+        v2 world = renderer_screen_to_world(corners[i]);
+        result.min = v2{MIN(result.min.x, world.x), MIN(result.min.y, world.y)};
+        result.max = v2{MAX(result.max.x, world.x), MAX(result.max.y, world.y)};
+    }
+    return result;
+}
+
+// @NOTE: Recomputes cull_rect and camera after the view or camera changes.
+function void
+renderer_update_view(void) {
+    Rect2 view = g_renderer->view_rect;
+    v2 view_center = 0.5f*(view.min + view.max);
+
+    if (!g_renderer->has_camera) {
+        g_renderer->cull_rect = view;
+        return;
+    }
+
+    f32 zoom = g_renderer->camera_zoom;
+    f32 c = cos(g_renderer->camera_rotation);
+    f32 s = sin(g_renderer->camera_rotation);
+    v2 center = g_renderer->camera_center;
+
+    // screen = zoom*rotate(world - center, -rotation) + view_center
+    m4x4 camera = {{
+        { c*zoom, s*zoom, 0, view_center.x - zoom*( c*center.x + s*center.y)},
+        {-s*zoom, c*zoom, 0, view_center.y - zoom*(-s*center.x + c*center.y)},
+        {      0,      0, 1, 0},
+        {      0,      0, 0, 1}
+    }};
+    g_renderer->camera = camera;
+    g_renderer->cull_rect = renderer_screen_to_world_bounds(view);
+}
+
+// @NOTE: Set the view and camera from the main thread before pushing the frame.
+function void
+set_view_rect(Rect2 view_rect) {
+    g_renderer->has_view  = true;
+    g_renderer->view_rect = view_rect;
+    renderer_update_view();
+}
+
+function void
+clear_view_rect(void) {
+    g_renderer->has_view = false;
+}
+
+// @NOTE: center is the world point that lands in the middle of the view rect.
+// rotation is in radians, counter-clockwise, and zoom scales world to screen.
+function void
+set_camera(v2 center, f32 rotation, f32 zoom) {
+    ASSERT(zoom > 0.0f);
+    g_renderer->has_camera      = true;
+    g_renderer->camera_center   = center;
+    g_renderer->camera_rotation = rotation;
+    g_renderer->camera_zoom     = zoom;
+    renderer_update_view();
+}
+
+function void
+clear_camera(void) {
+    g_renderer->has_camera = false;
+    renderer_update_view();
+}
+
+// @NOTE: World space rect a draw on list has to overlap to be seen: the view's
+// cull_rect cut down to the current clip. False if neither is set, or while
+// recording a static batch, since that geometry outlives both.
+function b32
+renderer_get_cull_rect(Draw_List *list, Rect2 *cull_rect) {
+    u32 clip = renderer_current_clip(list);
+    if ((!g_renderer->has_view && !clip) || list->recording) {
+        return false;
+    }
+
+    Rect2 result = g_renderer->has_view ? g_renderer->cull_rect : rect2_min_max(v2{-F32_MAX, -F32_MAX}, v2{F32_MAX, F32_MAX});
+    if (clip) {
+        result = intersect(result, g_renderer->clips[clip - 1].world_bounds);
+    }
+    *cull_rect = result;
+    return true;
+}
+
+// @NOTE: True if bounds (world space) can't be seen, so the draw should be skipped.
+function b32
+renderer_cull(Rect2 bounds) {
+    Draw_List *list = renderer_draw_list();
+    Rect2 cull_rect;
+    if (!renderer_get_cull_rect(list, &cull_rect)) {
+        return false;
+    }
+
+    ++list->cull_stats.tested;
+    if (!overlaps(bounds, cull_rect)) {
+        ++list->cull_stats.culled;
+        return true;
+    }
+    return false;
+}
+
+function b32
+renderer_gpu_culls_sprites(void) {
+    b32 result = (g_renderer->gpu_cull_sprites && g_renderer->gpu_cull_supported);
+    return result;
+}
+
+function Renderer_Cull_Stats
+renderer_get_cull_stats(void) {
+    Renderer_Cull_Stats result{};
+    for (u32 i = 0; i < RENDERER_DRAW_LIST_COUNT; ++i) {
+        result.tested += g_renderer->draw_lists[i].cull_stats.tested;
+        result.culled += g_renderer->draw_lists[i].cull_stats.culled;
+    }
+    return result;
+}
+
+// @NOTE: Caller holds clip_lock. Rect clips with the same rect and masks as an
+// existing one share its id, so sibling panels of the same size still batch.
+function u32
+renderer_add_clip(Renderer_Clip clip) {
+    if (!clip.mask_bit) {
+        for (u32 i = 0; i < g_renderer->clip_count; ++i) {
+            Renderer_Clip *other = g_renderer->clips + i;
+            if (!other->mask_bit && other->stencil_bits == clip.stencil_bits &&
+                other->rect.min.x == clip.rect.min.x && other->rect.min.y == clip.rect.min.y &&
+                other->rect.max.x == clip.rect.max.x && other->rect.max.y == clip.rect.max.y) {
+                return i + 1;
+            }
+        }
+    }
+
+    ASSERT(g_renderer->clip_count < RENDERER_CLIP_COUNT);
+    clip.world_bounds = renderer_screen_to_world_bounds(clip.rect);
+    g_renderer->clips[g_renderer->clip_count++] = clip;
+    return g_renderer->clip_count;
+}
+
+// @NOTE: Clips every draw on this thread until the matching pop_clip() to rect
+// (screen space), within whatever clip is already pushed.
+function void
+push_clip_rect(Rect2 rect) {
+    Draw_List *list = renderer_draw_list();
+    ASSERT(list->clip_depth < RENDERER_CLIP_STACK_DEPTH);
+    u32 parent = renderer_current_clip(list);
+
+    spin_lock(&g_renderer->clip_lock);
+    SCOPE_EXIT(spin_unlock(&g_renderer->clip_lock));
+
+    Renderer_Clip clip{};
+    clip.rect = rect;
+    if (parent) {
+        clip.rect         = intersect(rect, g_renderer->clips[parent - 1].rect);
+        clip.stencil_bits = g_renderer->clips[parent - 1].stencil_bits;
+    }
+    list->clip_stack[list->clip_depth++] = renderer_add_clip(clip);
+}
+
+// @NOTE: Like push_clip_rect(), but to the union of triangle_count triangles
+// (3 screen space points each), for rounded panels and other shapes a scissor
+// can't do.
+function void
+push_clip_mask(v2 *points, u32 triangle_count) {
+    Draw_List *list = renderer_draw_list();
+    ASSERT(list->clip_depth < RENDERER_CLIP_STACK_DEPTH);
+    u32 parent = renderer_current_clip(list);
+
+    spin_lock(&g_renderer->clip_lock);
+    SCOPE_EXIT(spin_unlock(&g_renderer->clip_lock));
+    ASSERT(g_renderer->clip_mask_count < RENDERER_CLIP_MASK_COUNT);
+
+    Renderer_Clip clip{};
+    clip.rect = rect2_inv_inf();
+    for (u32 i = 0; i < 3*triangle_count; ++i) {
+        clip.rect.min = v2{MIN(clip.rect.min.x, points[i].x), MIN(clip.rect.min.y, points[i].y)};
+        clip.rect.max = v2{MAX(clip.rect.max.x, points[i].x), MAX(clip.rect.max.y, points[i].y)};
+    }
+    if (parent) {
+        clip.rect         = intersect(clip.rect, g_renderer->clips[parent - 1].rect);
+        clip.stencil_bits = g_renderer->clips[parent - 1].stencil_bits;
+    }
+    clip.mask_bit           = 1 << g_renderer->clip_mask_count++;
+    clip.stencil_bits      |= clip.mask_bit;
+    clip.first_mask_vertex  = (u32)g_renderer->clip_mask_vertices.count;
+    clip.mask_vertex_count  = 3*triangle_count;
+
+    Vertex *vertices = g_renderer->clip_mask_vertices.push_n(3*triangle_count);
+    for (u32 i = 0; i < 3*triangle_count; ++i) {
+        vertices[i] = Vertex{renderer_screen_to_world(points[i]), v4{1,1,1,1}, v2{0,0}, 0};
+    }
+    list->clip_stack[list->clip_depth++] = renderer_add_clip(clip);
+}
+
+function void
+pop_clip(void) {
+    Draw_List *list = renderer_draw_list();
+    ASSERT(list->clip_depth > 0);
+    --list->clip_depth;
+}
+
+// @NOTE: End of frame, after the backend has drawn.
+function void
+renderer_clear_clips(void) {
+    g_renderer->clip_count      = 0;
+    g_renderer->clip_mask_count = 0;
+    g_renderer->clip_mask_vertices.clear();
+}
 
 function void
 push_sort_key_and_triangle(Sort_Key sort_key, Vertex a, Vertex b, Vertex c) {
-    g_renderer->sort_keys.push(sort_key);
-    g_renderer->vertices.push(a);
-    g_renderer->vertices.push(b);
-    g_renderer->vertices.push(c);
+    Draw_List *list = renderer_draw_list();
+    if (list->recording) {
+        // @NOTE: Static batches only hold quads; (a, b, c, c) is the triangle
+        // plus a degenerate one under the quad index pattern.
+        list->recording->opaque &= !sort_key.translucent;
+        list->recording->vertices.push(a);
+        list->recording->vertices.push(b);
+        list->recording->vertices.push(c);
+        list->recording->vertices.push(c);
+        return;
+    }
+    list->sort_keys.push(sort_key);
+    list->vertices.push(a);
+    list->vertices.push(b);
+    list->vertices.push(c);
 }
 
 function void
 draw_triangle(v2 a, v2 b, v2 c, v4 color) {
     ASSERT(g_renderer);
+    Rect2 bounds = rect2_min_max(v2{MIN(a.x, MIN(b.x, c.x)), MIN(a.y, MIN(b.y, c.y))},
+                                 v2{MAX(a.x, MAX(b.x, c.x)), MAX(a.y, MAX(b.y, c.y))});
+    if (renderer_cull(bounds)) {
+        return;
+    }
+
     Vertex v[3];
-    v[0] = Vertex{a, v4{1,1,1,1}, v2{1,1}};
-    v[1] = Vertex{b, v4{1,1,1,1}, v2{1,1}};
-    v[2] = Vertex{c, v4{1,1,1,1}, v2{1,1}};
-    push_sort_key_and_triangle({0}, v[0], v[1], v[2]);
+    v[0] = Vertex{a, v4{1,1,1,1}, v2{1,1}, 0};
+    v[1] = Vertex{b, v4{1,1,1,1}, v2{1,1}, 0};
+    v[2] = Vertex{c, v4{1,1,1,1}, v2{1,1}, 0};
+    // @NOTE: Slot 0, the backend's default texture, is opaque.
+    push_sort_key_and_triangle(make_sort_key(RENDERER_PIPELINE_SIMPLE, 0, true), v[0], v[1], v[2]);
+}
+
+// @NOTE: Caller holds image_lock.
+function u32
+renderer_alloc_texture_slot(void) {
+    u32 result;
+    if (g_renderer->texture_slot_free_list.count) {
+        result = g_renderer->texture_slot_free_list.data[--g_renderer->texture_slot_free_list.count];
+    } else {
+        ASSERT(g_renderer->texture_slot_count + 1 < RENDERER_TEXTURE_SLOT_COUNT);
+        result = ++g_renderer->texture_slot_count;
+    }
+    return result;
 }
 
+// @NOTE: Called by the backend once the image using the slot is destroyed, which
+// can race with worker threads registering images.
 function void
-draw_textured_quad(v2 center, v2 dim, Image image) {
-    if (!g_renderer->image_hash_table.get(image).found) {
-        g_renderer->image_hash_table.insert(image, 0);
-        enqueue(&g_renderer->image_create_queue, image);
+renderer_free_texture_slot(u32 slot) {
+    ASSERT(slot != 0);
+    spin_lock(&g_renderer->image_lock);
+    SCOPE_EXIT(spin_unlock(&g_renderer->image_lock));
+    g_renderer->texture_slot_free_list.push(slot);
+}
+
+// @NOTE: Packs into the newest page, opening a new one when it's full. Older
+// pages aren't revisited; with small images they're close to full anyway.
+function b32
+renderer_pack_into_atlas(Image image, Texture_Region *region) {
+    u32 padded_width  = image.width  + 2*RENDERER_ATLAS_PADDING;
+    u32 padded_height = image.height + 2*RENDERER_ATLAS_PADDING;
+
+    u32 x, y;
+    Atlas_Page *page = 0;
+    if (g_renderer->atlas_page_count) {
+        page = g_renderer->atlas_pages + g_renderer->atlas_page_count - 1;
+        if (!atlas_page_pack(page, padded_width, padded_height, &x, &y)) {
+            page = 0;
+        }
+    }
+
+    if (!page) {
+        if (g_renderer->atlas_page_count == RENDERER_ATLAS_PAGE_COUNT) {
+            return false;
+        }
+        page = g_renderer->atlas_pages + g_renderer->atlas_page_count++;
+        atlas_page_init(page, renderer_alloc_texture_slot());
+
+        Texture_Upload upload{};
+        upload.kind = TEXTURE_UPLOAD_ATLAS_PAGE;
+        upload.slot = page->slot;
+        upload.page = (u32)(page - g_renderer->atlas_pages);
+        g_renderer->image_create_queue.push(upload);
+
+        b32 packed = atlas_page_pack(page, padded_width, padded_height, &x, &y);
+        ASSERT(packed);
+    }
+
+    Texture_Upload upload{};
+    upload.kind  = TEXTURE_UPLOAD_ATLAS_REGION;
+    upload.image = image;
+    upload.slot  = page->slot;
+    upload.page  = (u32)(page - g_renderer->atlas_pages);
+    upload.x     = x;
+    upload.y     = y;
+    g_renderer->image_create_queue.push(upload);
+
+    f32 inv_dim = 1.0f / (f32)ATLAS_PAGE_DIM;
+    region->slot     = page->slot;
+    region->uv_min   = v2{(f32)(x + RENDERER_ATLAS_PADDING), (f32)(y + RENDERER_ATLAS_PADDING)} * inv_dim;
+    region->uv_max   = region->uv_min + v2{(f32)image.width, (f32)image.height} * inv_dim;
+    region->in_atlas = true;
+    return true;
+}
+
+function b32
+renderer_image_is_opaque(Image image) {
+    if (image.alpha != IMAGE_ALPHA_DETECT) {
+        return image.alpha == IMAGE_ALPHA_OPAQUE;
+    }
+    if (!image.data) {
+        return false;
+    }
+
+    u32 *texels = (u32 *)image.data;
+    u32 texel_count = image.width*image.height;
+    u32 alpha = 0xFF000000;
+    for (u32 i = 0; i < texel_count; ++i) {
+        alpha &= texels[i];
+    }
+    return alpha == 0xFF000000;
+}
+
+// @NOTE: Caller holds image_lock.
+function Texture_Region
+renderer_register_new_image(Image image) {
+    Texture_Region region{};
+    b32 small = (image.width  <= RENDERER_ATLAS_MAX_IMAGE_DIM &&
+                 image.height <= RENDERER_ATLAS_MAX_IMAGE_DIM);
+    if (!small || !renderer_pack_into_atlas(image, &region)) {
+        Texture_Upload upload{};
+        upload.kind  = TEXTURE_UPLOAD_IMAGE;
+        upload.image = image;
+        upload.slot  = renderer_alloc_texture_slot();
+        g_renderer->image_create_queue.push(upload);
+
+        region.slot   = upload.slot;
+        region.uv_min = v2{0, 0};
+        region.uv_max = v2{1, 1};
+    }
+    region.opaque = renderer_image_is_opaque(image);
+
+    g_renderer->image_hash_table.insert(image, region);
+    return region;
+}
+
+function Texture_Region
+renderer_register_image(Image image) {
+    Draw_List *list = renderer_draw_list();
+    if (list->has_cached_image && list->cached_image == image) {
+        return list->cached_region;
+    }
+
+    spin_lock(&g_renderer->image_lock);
+    SCOPE_EXIT(spin_unlock(&g_renderer->image_lock));
+
+    Texture_Region region{};
+    Hash_Get_Result<Texture_Region> lookup = g_renderer->image_hash_table.get(image);
+    if (lookup.found) {
+        region = lookup.value;
+    } else {
+        region = renderer_register_new_image(image);
+    }
+
+    list->has_cached_image = true;
+    list->cached_image     = image;
+    list->cached_region    = region;
+    return region;
+}
+
+// @NOTE: Call between frames. The backend destroys the image before it draws the
+// next frame, so draws already pushed with its slot would sample a dead descriptor.
+// Atlas images only drop out of the table; their space in the page isn't reclaimed.
+function void
+renderer_unregister_image(Image image) {
+    spin_lock(&g_renderer->image_lock);
+    SCOPE_EXIT(spin_unlock(&g_renderer->image_lock));
+
+    Hash_Get_Result<Texture_Region> lookup = g_renderer->image_hash_table.get(image);
+    if (lookup.found) {
+        g_renderer->image_hash_table.remove(image);
+        if (!lookup.value.in_atlas) {
+            g_renderer->image_destroy_queue.push(image.id);
+        }
+    }
+
+    for (u32 i = 0; i < RENDERER_DRAW_LIST_COUNT; ++i) {
+        Draw_List *list = g_renderer->draw_lists + i;
+        if (list->has_cached_image && list->cached_image == image) {
+            list->has_cached_image = false;
+        }
+    }
+}
+
+function u16
+unorm16(f32 x) {
+    u16 result = (u16)round_f32_to_u32(clamp01(x)*65535.0f);
+    return result;
+}
+
+function u32
+pack_rgba8(v4 color) {
+    u32 r = round_f32_to_u32(clamp01(color.r)*255.0f);
+    u32 g = round_f32_to_u32(clamp01(color.g)*255.0f);
+    u32 b = round_f32_to_u32(clamp01(color.b)*255.0f);
+    u32 a = round_f32_to_u32(clamp01(color.a)*255.0f);
+    u32 result = (r | (g << 8) | (b << 16) | (a << 24));
+    return result;
+}
+
+function b32
+vertex_fits_compact(Vertex v) {
+    b32 result = (v.color.r >= 0.0f && v.color.r <= 1.0f &&
+                  v.color.g >= 0.0f && v.color.g <= 1.0f &&
+                  v.color.b >= 0.0f && v.color.b <= 1.0f &&
+                  v.color.a >= 0.0f && v.color.a <= 1.0f &&
+                  v.uv.x >= 0.0f && v.uv.x <= 1.0f &&
+                  v.uv.y >= 0.0f && v.uv.y <= 1.0f);
+    return result;
+}
+
+function Vertex_Compact
+vertex_compact(Vertex v) {
+    Vertex_Compact result;
+    result.position = v.position;
+    result.color    = pack_rgba8(v.color);
+    result.uv[0]    = unorm16(v.uv.x);
+    result.uv[1]    = unorm16(v.uv.y);
+    result.texture  = v.texture;
+    return result;
+}
+
+// @NOTE: Corners in index pattern order: top-left, top-right, bottom-left, bottom-right.
+function void
+push_sort_key_and_quad(Sort_Key sort_key, Vertex v[4]) {
+    Draw_List *list = renderer_draw_list();
+    if (list->recording) {
+        list->recording->opaque &= !sort_key.translucent;
+        for (u32 i = 0; i < 4; ++i) {
+            list->recording->vertices.push(v[i]);
+        }
+        return;
+    }
+    list->quad_sort_keys.push(sort_key);
+    for (u32 i = 0; i < 4; ++i) {
+        list->quad_vertices.push(v[i]);
+    }
+}
+
+function void
+push_sort_key_and_compact_quad(Sort_Key sort_key, Vertex_Compact v[4]) {
+    Draw_List *list = renderer_draw_list();
+    list->compact_quad_sort_keys.push(sort_key);
+    for (u32 i = 0; i < 4; ++i) {
+        list->compact_quad_vertices.push(v[i]);
+    }
+}
+
+function void
+push_sort_key_and_sprite(Sort_Key sort_key, Sprite_Instance sprite) {
+    Draw_List *list = renderer_draw_list();
+    list->sprite_sort_keys.push(sort_key);
+    list->sprites.push(sprite);
+}
+
+// @NOTE: Corners in index pattern order, uv relative to the image. Goes through
+// the compact vertex layout when every corner fits it, which halves the upload.
+// Doesn't cull; draw_quad() does.
+function void
+push_textured_quad(Vertex v[4], Image image) {
+    Texture_Region region = renderer_register_image(image);
+    u32 texture = region.slot;
+
+    b32 fits_compact = true;
+    b32 opaque = region.opaque;
+    if (region.in_atlas) {
+        v2 region_dim = region.uv_max - region.uv_min;
+        for (u32 i = 0; i < 4; ++i) {
+            v[i].uv = region.uv_min + hadamard(v[i].uv, region_dim);
+        }
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        v[i].texture = texture;
+        fits_compact &= vertex_fits_compact(v[i]);
+        opaque &= (v[i].color.a >= 1.0f);
+    }
+
+    if (fits_compact && !renderer_draw_list()->recording) {
+        Vertex_Compact compact[4];
+        for (u32 i = 0; i < 4; ++i) {
+            compact[i] = vertex_compact(v[i]);
+        }
+        push_sort_key_and_compact_quad(make_sort_key(RENDERER_PIPELINE_SIMPLE_COMPACT, texture, opaque), compact);
+    } else {
+        push_sort_key_and_quad(make_sort_key(RENDERER_PIPELINE_SIMPLE, texture, opaque), v);
+    }
+}
+
+function void
+draw_quad(Vertex v[4], Image image) {
+    Rect2 bounds = rect2_min_max(v[0].position, v[0].position);
+    for (u32 i = 1; i < 4; ++i) {
+        bounds.min = v2{MIN(bounds.min.x, v[i].position.x), MIN(bounds.min.y, v[i].position.y)};
+        bounds.max = v2{MAX(bounds.max.x, v[i].position.x), MAX(bounds.max.y, v[i].position.y)};
+    }
+    if (renderer_cull(bounds)) {
+        return;
+    }
+
+    push_textured_quad(v, image);
+}
+
+// @NOTE: rotation is in radians, counter-clockwise. uv_min/uv_max select part of
+// the image, in [0, 1]. Doesn't cull; draw_sprite_uv() does.
+function void
+push_sprite_uv(v2 center, v2 dim, f32 rotation, v4 color, Image image, v2 uv_min, v2 uv_max) {
+    if (renderer_draw_list()->recording) {
+        // @NOTE: Static batches are vertices only, so expand the corners here the way
+        // sprite_vs does.
+        f32 c = cos(rotation);
+        f32 s = sin(rotation);
+        v2 half_dim = 0.5f*dim;
+        v2 corners[4] = {v2{-1, 1}, v2{ 1, 1}, v2{-1,-1}, v2{ 1,-1}};
+        Vertex v[4];
+        for (u32 i = 0; i < 4; ++i) {
+            v2 p = hadamard(corners[i], half_dim);
+            v2 uv_t = 0.5f*corners[i] + v2{0.5f, 0.5f};
+            v[i].position = center + v2{c*p.x - s*p.y, s*p.x + c*p.y};
+            v[i].color    = color;
+            v[i].uv       = uv_min + hadamard(uv_t, uv_max - uv_min);
+            v[i].texture  = 0;
+        }
+        push_textured_quad(v, image);
+        return;
+    }
+
+    Texture_Region region = renderer_register_image(image);
+    v2 region_dim = region.uv_max - region.uv_min;
+    uv_min = region.uv_min + hadamard(uv_min, region_dim);
+    uv_max = region.uv_min + hadamard(uv_max, region_dim);
+
+    Sprite_Instance sprite{};
+    sprite.center       = center;
+    sprite.half_dim     = 0.5f*dim;
+    sprite.uv_min[0]    = unorm16(uv_min.x);
+    sprite.uv_min[1]    = unorm16(uv_min.y);
+    sprite.uv_max[0]    = unorm16(uv_max.x);
+    sprite.uv_max[1]    = unorm16(uv_max.y);
+    sprite.color        = pack_rgba8(color);
+    sprite.texture      = (u16)region.slot;
+    sprite.rotation     = (u16)(round_f32_to_s32(rotation*(65536.0f / (2.0f*pi32))) & 0xFFFF);
+
+    b32 opaque = (region.opaque && color.a >= 1.0f);
+    push_sort_key_and_sprite(make_sort_key(RENDERER_PIPELINE_SPRITE, region.slot, opaque), sprite);
+}
+
+function void
+draw_sprite_uv(v2 center, v2 dim, f32 rotation, v4 color, Image image, v2 uv_min, v2 uv_max) {
+    // @NOTE: Bounds of any rotation, so no trig here. sprite_cull.comp uses the same.
+    v2 half_dim = 0.5f*dim;
+    if (rotation != 0.0f) {
+        f32 radius = half_dim.x + half_dim.y;
+        half_dim = v2{radius, radius};
+    }
+    if (!renderer_gpu_culls_sprites() && renderer_cull(rect2_cen_half_dim(center, half_dim))) {
+        return;
+    }
+
+    push_sprite_uv(center, dim, rotation, color, image, uv_min, uv_max);
+}
+
+function void
+draw_sprite(v2 center, v2 dim, f32 rotation, v4 color, Image image) {
+    draw_sprite_uv(center, dim, rotation, color, image, v2{0, 0}, v2{1, 1});
+}
+
+function void
+draw_textured_quad_uv(v2 center, v2 dim, Image image, v2 uv_min, v2 uv_max) {
+    if (g_renderer->instanced_sprites) {
+        draw_sprite_uv(center, dim, 0.0f, v4{1,1,1,1}, image, uv_min, uv_max);
+        return;
     }
 
     f32 w = 0.5f*dim.x;
     f32 h = 0.5f*dim.y;
+    if (renderer_cull(rect2_cen_half_dim(center, v2{w, h}))) {
+        return;
+    }
 
     Vertex v[4];
-    v[0] = {center + v2{-w, h}, v4{1,1,1,1}, v2{0,1}};
-    v[1] = {center + v2{ w, h}, v4{1,1,1,1}, v2{1,1}};
-    v[2] = {center + v2{-w,-h}, v4{1,1,1,1}, v2{0,0}};
-    v[3] = {center + v2{ w,-h}, v4{1,1,1,1}, v2{1,0}};
+    v[0] = {center + v2{-w, h}, v4{1,1,1,1}, v2{uv_min.x, uv_max.y}, 0};
+    v[1] = {center + v2{ w, h}, v4{1,1,1,1}, v2{uv_max.x, uv_max.y}, 0};
+    v[2] = {center + v2{-w,-h}, v4{1,1,1,1}, v2{uv_min.x, uv_min.y}, 0};
+    v[3] = {center + v2{ w,-h}, v4{1,1,1,1}, v2{uv_max.x, uv_min.y}, 0};
+
+    push_textured_quad(v, image);
+}
+
+function void
+draw_textured_quad(v2 center, v2 dim, Image image) {
+    draw_textured_quad_uv(center, dim, image, v2{0, 0}, v2{1, 1});
+}
 
-    push_sort_key_and_triangle({image.id}, v[0], v[1], v[2]);
-    push_sort_key_and_triangle({image.id}, v[2], v[1], v[3]);
+// @NOTE: For sprite sheets: draws the texel rect [texel_min, texel_max) of image.
+function void
+draw_textured_sub_quad(v2 center, v2 dim, Image image, v2 texel_min, v2 texel_max) {
+    ASSERT(image.width && image.height);
+    v2 inv_image_dim = v2{1.0f / (f32)image.width, 1.0f / (f32)image.height};
+    draw_textured_quad_uv(center, dim, image, hadamard(texel_min, inv_image_dim), hadamard(texel_max, inv_image_dim));
+}
+
+// @NOTE: What draw_textured_quads() stamps on every quad of one image: the sort
+// key minus depth, and per corner the color and uv the way they sit in
+// Vertex_Compact, right after the position.
+struct Quad_Template {
+    b32 valid;
+    Image image;
+    Sort_Key sort_key;
+    u32 uv[4];              // unorm16 pairs, corners in index pattern order
+    __m128 color_uv[4];     // (color, uv, 0, 0)
+};
+
+struct Quad_Batch {
+    f32 *centers_x;
+    f32 *centers_y;
+    f32 *dims_x;
+    f32 *dims_y;
+    Image *images;
+
+    b32 cull;
+    Rect2 cull_rect;
+
+    Sort_Key *sort_keys;
+    Vertex_Compact *vertices;
+    u32 depth;
+    u32 written;
+
+    Quad_Template quad_template;
+};
+
+function void
+renderer_set_quad_template(Quad_Template *t, Image image) {
+    Texture_Region region = renderer_register_image(image);
+    Draw_List *list = renderer_draw_list();
+    t->valid                = true;
+    t->image                = image;
+    t->sort_key.layer       = list->layer;
+    t->sort_key.translucent = list->translucent || !region.opaque;
+    t->sort_key.pipeline    = RENDERER_PIPELINE_SIMPLE_COMPACT;
+    t->sort_key.clip        = renderer_current_clip(list);
+    t->sort_key.texture     = region.slot;
+    t->sort_key.depth       = 0;
+
+    u32 u0 = unorm16(region.uv_min.x);
+    u32 v0 = unorm16(region.uv_min.y);
+    u32 u1 = unorm16(region.uv_max.x);
+    u32 v1 = unorm16(region.uv_max.y);
+    t->uv[0] = u0 | (v1 << 16);
+    t->uv[1] = u1 | (v1 << 16);
+    t->uv[2] = u0 | (v0 << 16);
+    t->uv[3] = u1 | (v0 << 16);
+    for (u32 i = 0; i < 4; ++i) {
+        t->color_uv[i] = _mm_castsi128_ps(_mm_setr_epi32(-1, (s32)t->uv[i], 0, 0));
+    }
+}
+
+function void
+renderer_quad_batch_push_key(Quad_Batch *batch, Quad_Template *t) {
+    Sort_Key *key = batch->sort_keys + batch->written;
+    *key = t->sort_key;
+    key->depth = batch->depth + batch->written;
+    ++batch->written;
+}
+
+function void
+renderer_expand_quads_scalar(Quad_Batch *batch, u32 first, u32 count) {
+    for (u32 i = first; i < count; ++i) {
+        f32 w = 0.5f*batch->dims_x[i];
+        f32 h = 0.5f*batch->dims_y[i];
+        f32 x0 = batch->centers_x[i] - w;
+        f32 x1 = batch->centers_x[i] + w;
+        f32 y0 = batch->centers_y[i] - h;
+        f32 y1 = batch->centers_y[i] + h;
+        if (batch->cull && !overlaps(rect2_min_max(v2{x0, y0}, v2{x1, y1}), batch->cull_rect)) {
+            continue;
+        }
+
+        Quad_Template *t = &batch->quad_template;
+        if (!t->valid || !(t->image == batch->images[i])) {
+            renderer_set_quad_template(t, batch->images[i]);
+        }
+        Vertex_Compact *v = batch->vertices + 4*batch->written;
+        v2 corners[4] = {v2{x0, y1}, v2{x1, y1}, v2{x0, y0}, v2{x1, y0}};
+        for (u32 k = 0; k < 4; ++k) {
+            v[k].position = corners[k];
+            v[k].color    = 0xFFFFFFFF;
+            v[k].uv[0]    = (u16)t->uv[k];
+            v[k].uv[1]    = (u16)(t->uv[k] >> 16);
+            v[k].texture  = t->sort_key.texture;
+        }
+        renderer_quad_batch_push_key(batch, t);
+    }
+}
+
+// @NOTE: Corners come in as (x, y) in the low half. Position, color and uv of each
+// vertex go out as one 16-byte store. Everything is loaded up front, since those
+// stores may alias the batch as far as the compiler knows.
+function void
+renderer_emit_quad_sse2(Quad_Batch *batch, u32 index, __m128 tl, __m128 tr, __m128 bl, __m128 br) {
+    // @NOTE: Images mostly come in runs, so this is one compare per quad.
+    Quad_Template *t = &batch->quad_template;
+    if (!t->valid || !(t->image == batch->images[index])) {
+        renderer_set_quad_template(t, batch->images[index]);
+    }
+    u32 written = batch->written;
+    u32 texture = t->sort_key.texture;
+    Sort_Key key = t->sort_key;
+    key.depth = batch->depth + written;
+    __m128 color_uv0 = t->color_uv[0];
+    __m128 color_uv1 = t->color_uv[1];
+    __m128 color_uv2 = t->color_uv[2];
+    __m128 color_uv3 = t->color_uv[3];
+    Vertex_Compact *v = batch->vertices + 4*written;
+    Sort_Key *keys = batch->sort_keys;
+    batch->written = written + 1;
+
+    _mm_storeu_ps((f32 *)(v + 0), _mm_movelh_ps(tl, color_uv0));
+    _mm_storeu_ps((f32 *)(v + 1), _mm_movelh_ps(tr, color_uv1));
+    _mm_storeu_ps((f32 *)(v + 2), _mm_movelh_ps(bl, color_uv2));
+    _mm_storeu_ps((f32 *)(v + 3), _mm_movelh_ps(br, color_uv3));
+    v[0].texture = texture;
+    v[1].texture = texture;
+    v[2].texture = texture;
+    v[3].texture = texture;
+    keys[written] = key;
+}
+
+// @NOTE: Writes quads first..first+3 whose bit is set in mask.
+function void
+renderer_emit_quads_sse2(Quad_Batch *batch, u32 first, u32 mask, __m128 x0, __m128 y0, __m128 x1, __m128 y1) {
+    // @NOTE: Corner positions as (x, y) pairs, quads 0 and 1 in lo, 2 and 3 in hi.
+    __m128 tl_lo = _mm_unpacklo_ps(x0, y1);
+    __m128 tl_hi = _mm_unpackhi_ps(x0, y1);
+    __m128 tr_lo = _mm_unpacklo_ps(x1, y1);
+    __m128 tr_hi = _mm_unpackhi_ps(x1, y1);
+    __m128 bl_lo = _mm_unpacklo_ps(x0, y0);
+    __m128 bl_hi = _mm_unpackhi_ps(x0, y0);
+    __m128 br_lo = _mm_unpacklo_ps(x1, y0);
+    __m128 br_hi = _mm_unpackhi_ps(x1, y0);
+
+    if (mask & 1) {
+        renderer_emit_quad_sse2(batch, first + 0, tl_lo, tr_lo, bl_lo, br_lo);
+    }
+    if (mask & 2) {
+        renderer_emit_quad_sse2(batch, first + 1, _mm_movehl_ps(tl_lo, tl_lo), _mm_movehl_ps(tr_lo, tr_lo),
+                                _mm_movehl_ps(bl_lo, bl_lo), _mm_movehl_ps(br_lo, br_lo));
+    }
+    if (mask & 4) {
+        renderer_emit_quad_sse2(batch, first + 2, tl_hi, tr_hi, bl_hi, br_hi);
+    }
+    if (mask & 8) {
+        renderer_emit_quad_sse2(batch, first + 3, _mm_movehl_ps(tl_hi, tl_hi), _mm_movehl_ps(tr_hi, tr_hi),
+                                _mm_movehl_ps(bl_hi, bl_hi), _mm_movehl_ps(br_hi, br_hi));
+    }
+}
+
+function void
+renderer_expand_quads_sse2(Quad_Batch *batch, u32 count) {
+    __m128 half       = _mm_set1_ps(0.5f);
+    __m128 cull_min_x = _mm_set1_ps(batch->cull_rect.min.x);
+    __m128 cull_min_y = _mm_set1_ps(batch->cull_rect.min.y);
+    __m128 cull_max_x = _mm_set1_ps(batch->cull_rect.max.x);
+    __m128 cull_max_y = _mm_set1_ps(batch->cull_rect.max.y);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(batch->centers_x + i);
+        __m128 cy = _mm_loadu_ps(batch->centers_y + i);
+        __m128 w  = _mm_mul_ps(half, _mm_loadu_ps(batch->dims_x + i));
+        __m128 h  = _mm_mul_ps(half, _mm_loadu_ps(batch->dims_y + i));
+        __m128 x0 = _mm_sub_ps(cx, w);
+        __m128 x1 = _mm_add_ps(cx, w);
+        __m128 y0 = _mm_sub_ps(cy, h);
+        __m128 y1 = _mm_add_ps(cy, h);
+
+        u32 mask = 0xF;
+        if (batch->cull) {
+            // @NOTE: Same test as overlaps().
+            __m128 visible = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(x0, cull_max_x), _mm_cmplt_ps(y0, cull_max_y)),
+                                        _mm_and_ps(_mm_cmplt_ps(cull_min_x, x1), _mm_cmplt_ps(cull_min_y, y1)));
+            mask = (u32)_mm_movemask_ps(visible);
+        }
+        renderer_emit_quads_sse2(batch, i, mask, x0, y0, x1, y1);
+    }
+    renderer_expand_quads_scalar(batch, i, count);
+}
+
+function TARGET_AVX2 void
+renderer_expand_quads_avx2(Quad_Batch *batch, u32 count) {
+    __m256 half       = _mm256_set1_ps(0.5f);
+    __m256 cull_min_x = _mm256_set1_ps(batch->cull_rect.min.x);
+    __m256 cull_min_y = _mm256_set1_ps(batch->cull_rect.min.y);
+    __m256 cull_max_x = _mm256_set1_ps(batch->cull_rect.max.x);
+    __m256 cull_max_y = _mm256_set1_ps(batch->cull_rect.max.y);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(batch->centers_x + i);
+        __m256 cy = _mm256_loadu_ps(batch->centers_y + i);
+        __m256 w  = _mm256_mul_ps(half, _mm256_loadu_ps(batch->dims_x + i));
+        __m256 h  = _mm256_mul_ps(half, _mm256_loadu_ps(batch->dims_y + i));
+        __m256 x0 = _mm256_sub_ps(cx, w);
+        __m256 x1 = _mm256_add_ps(cx, w);
+        __m256 y0 = _mm256_sub_ps(cy, h);
+        __m256 y1 = _mm256_add_ps(cy, h);
+
+        u32 mask = 0xFF;
+        if (batch->cull) {
+            __m256 visible = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x0, cull_max_x, _CMP_LT_OQ),
+                                                         _mm256_cmp_ps(y0, cull_max_y, _CMP_LT_OQ)),
+                                           _mm256_and_ps(_mm256_cmp_ps(cull_min_x, x1, _CMP_LT_OQ),
+                                                         _mm256_cmp_ps(cull_min_y, y1, _CMP_LT_OQ)));
+            mask = (u32)_mm256_movemask_ps(visible);
+        }
+        renderer_emit_quads_sse2(batch, i, mask & 0xF,
+                                 _mm256_castps256_ps128(x0), _mm256_castps256_ps128(y0),
+                                 _mm256_castps256_ps128(x1), _mm256_castps256_ps128(y1));
+        renderer_emit_quads_sse2(batch, i + 4, mask >> 4,
+                                 _mm256_extractf128_ps(x0, 1), _mm256_extractf128_ps(y0, 1),
+                                 _mm256_extractf128_ps(x1, 1), _mm256_extractf128_ps(y1, 1));
+    }
+    renderer_expand_quads_scalar(batch, i, count);
+}
+
+// @NOTE: draw_textured_quad() for many quads at once, from parallel arrays: quad i
+// is centered on (centers_x[i], centers_y[i]) and dims_x[i] by dims_y[i]. Stream
+// space is reserved once, and corners are expanded 4 or 8 quads at a time into
+// the compact quad stream, culled quads skipped. While recording a static batch
+// or with instanced_sprites on, it's a loop over draw_textured_quad().
+function void
+draw_textured_quads(u32 count, f32 *centers_x, f32 *centers_y, f32 *dims_x, f32 *dims_y, Image *images) {
+    Draw_List *list = renderer_draw_list();
+    if (list->recording || g_renderer->instanced_sprites) {
+        for (u32 i = 0; i < count; ++i) {
+            draw_textured_quad(v2{centers_x[i], centers_y[i]}, v2{dims_x[i], dims_y[i]}, images[i]);
+        }
+        return;
+    }
+
+    if (g_renderer->simd == RENDERER_SIMD_DETECT) {
+        g_renderer->simd = cpu_has_avx2() ? RENDERER_SIMD_AVX2 : RENDERER_SIMD_SSE2;
+    }
+
+    umm first_key    = list->compact_quad_sort_keys.count;
+    umm first_vertex = list->compact_quad_vertices.count;
+
+    Quad_Batch batch{};
+    batch.centers_x = centers_x;
+    batch.centers_y = centers_y;
+    batch.dims_x    = dims_x;
+    batch.dims_y    = dims_y;
+    batch.images    = images;
+    batch.cull      = renderer_get_cull_rect(list, &batch.cull_rect);
+    batch.sort_keys = list->compact_quad_sort_keys.push_n(count);
+    batch.vertices  = list->compact_quad_vertices.push_n(4*count);
+    batch.depth     = list->sort_sequence;
+
+    switch(g_renderer->simd) {
+        case RENDERER_SIMD_AVX2: {
+            renderer_expand_quads_avx2(&batch, count);
+        } break;
+        case RENDERER_SIMD_SSE2: {
+            renderer_expand_quads_sse2(&batch, count);
+        } break;
+        default: {
+            renderer_expand_quads_scalar(&batch, 0, count);
+        } break;
+    }
+
+    // @NOTE: Hand back what culled quads didn't use.
+    list->compact_quad_sort_keys.count = first_key + batch.written;
+    list->compact_quad_vertices.count  = first_vertex + 4*batch.written;
+    list->sort_sequence += batch.written;
+    if (batch.cull) {
+        list->cull_stats.tested += count;
+        list->cull_stats.culled += count - batch.written;
+    }
+}
+
+function Static_Batch_Data *
+renderer_get_static_batch(Static_Batch batch) {
+    ASSERT(batch.id > 0 && batch.id <= g_renderer->static_batch_count);
+    Static_Batch_Data *result = g_renderer->static_batches + batch.id - 1;
+    ASSERT(result->used);
+    return result;
+}
+
+function Static_Batch
+create_static_batch(void) {
+    Static_Batch result{};
+    if (g_renderer->static_batch_free_list.count) {
+        result.id = g_renderer->static_batch_free_list.data[--g_renderer->static_batch_free_list.count];
+    } else {
+        ASSERT(g_renderer->static_batch_count < RENDERER_STATIC_BATCH_COUNT);
+        result.id = ++g_renderer->static_batch_count;
+    }
+    g_renderer->static_batches[result.id - 1].used = true;
+    return result;
+}
+
+// @NOTE: Until end_static_batch(), the calling thread's draws are recorded into
+// batch instead of drawn, replacing whatever it held. Layer and depth are ignored;
+// the batch draws in recording order wherever draw_static_batch() puts it.
+function void
+begin_static_batch(Static_Batch batch) {
+    Draw_List *list = renderer_draw_list();
+    ASSERT(!list->recording);
+    list->recording = renderer_get_static_batch(batch);
+    list->recording->vertices.clear();
+    list->recording->opaque = true;
+}
+
+function void
+end_static_batch(void) {
+    Draw_List *list = renderer_draw_list();
+    ASSERT(list->recording);
+    Static_Batch_Data *data = list->recording;
+    data->bounds = rect2_inv_inf();
+    for (umm i = 0; i < data->vertices.count; ++i) {
+        v2 p = data->vertices.data[i].position;
+        data->bounds.min = v2{MIN(data->bounds.min.x, p.x), MIN(data->bounds.min.y, p.y)};
+        data->bounds.max = v2{MAX(data->bounds.max.x, p.x), MAX(data->bounds.max.y, p.y)};
+    }
+    ++data->generation;
+    list->recording = 0;
+}
+
+function void
+destroy_static_batch(Static_Batch batch) {
+    Static_Batch_Data *data = renderer_get_static_batch(batch);
+    data->used = false;
+    data->vertices.clear();
+    ++data->generation;
+    g_renderer->static_batch_free_list.push(batch.id);
+}
+
+// @NOTE: Sorts like any other draw, at the current layer with the next depth.
+function void
+draw_static_batch(Static_Batch batch) {
+    Static_Batch_Data *data = renderer_get_static_batch(batch);
+    if (data->vertices.count == 0 || renderer_cull(data->bounds)) {
+        return;
+    }
+
+    Draw_List *list = renderer_draw_list();
+    ASSERT(!list->recording);
+    list->static_sort_keys.push(make_sort_key(RENDERER_PIPELINE_SIMPLE, 0, data->opaque));
+    list->static_draws.push(batch);
+}
+
+function u64
+sort_key_pack(Sort_Key key) {
+    u64 layer_mask    = (1ull << SORT_KEY_LAYER_BITS) - 1;
+    u64 pipeline_mask = (1ull << SORT_KEY_PIPELINE_BITS) - 1;
+    u64 clip_mask     = (1ull << SORT_KEY_CLIP_BITS) - 1;
+    u64 texture_mask  = (1ull << SORT_KEY_TEXTURE_BITS) - 1;
+    u64 depth_mask    = (1ull << SORT_KEY_DEPTH_BITS) - 1;
+
+    u64 layer    = key.layer & layer_mask;
+    u64 pipeline = key.pipeline & pipeline_mask;
+    u64 clip     = key.clip & clip_mask;
+    u64 texture  = key.texture & texture_mask;
+    u64 depth    = key.depth & depth_mask;
+
+    u64 result;
+    if (key.translucent) {
+        result = 1;
+        result = (result << SORT_KEY_LAYER_BITS)    | layer;
+        result = (result << SORT_KEY_DEPTH_BITS)    | depth;
+        result = (result << SORT_KEY_PIPELINE_BITS) | pipeline;
+        result = (result << SORT_KEY_CLIP_BITS)     | clip;
+        result = (result << SORT_KEY_TEXTURE_BITS)  | texture;
+    } else {
+        result = 0;
+        result = (result << SORT_KEY_LAYER_BITS)    | (layer_mask - layer);
+        result = (result << SORT_KEY_PIPELINE_BITS) | pipeline;
+        result = (result << SORT_KEY_CLIP_BITS)     | clip;
+        result = (result << SORT_KEY_TEXTURE_BITS)  | texture;
+        result = (result << SORT_KEY_DEPTH_BITS)    | depth;
+    }
+    return result;
 }
 
 function b32
 compare_sort_key(Sort_Key a, Sort_Key b) {
-    if (a.image_id > b.image_id) return true;
+    if (sort_key_pack(a) > sort_key_pack(b)) return true;
     return false;
 }
 
+// @NOTE: Only fields that need a state change on the GPU break a batch: the
+// pipeline, blending, the layer, which sets the draw's z, and the clip, which sets
+// scissor and stencil. Depth order doesn't, and neither does texture since it's bindless.
 function b32
-sort_key_is_same(Sort_Key a, Sort_Key b) {
-    if (a.image_id == b.image_id) return true;
+sort_key_same_state(Sort_Key a, Sort_Key b) {
+    if (a.pipeline == b.pipeline && a.translucent == b.translucent && a.layer == b.layer && a.clip == b.clip) return true;
     return false;
 }
 
+// @NOTE: Stable LSD radix sort, 8 bits per pass. Histograms for every byte are built
+// in one sweep, and a pass is skipped when all keys share that byte.
+// Returns whichever of the two buffers holds the sorted result.
+function Sort_Entry *
+radix_sort(Sort_Entry *entries, Sort_Entry *scratch, umm count) {
+    u32 histograms[8][256];
+    zerosize(histograms, sizeof(histograms));
+
+    for (umm i = 0; i < count; ++i) {
+        u64 key = entries[i].key;
+        for (u32 b = 0; b < 8; ++b) {
+            ++histograms[b][(key >> (8*b)) & 0xFF];
+        }
+    }
+
+    Sort_Entry *src = entries;
+    Sort_Entry *dst = scratch;
+    for (u32 b = 0; b < 8; ++b) {
+        u32 shift = 8*b;
+        u32 *histogram = histograms[b];
+        if (count == 0 || histogram[(src[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        u32 offset = 0;
+        for (u32 i = 0; i < 256; ++i) {
+            u32 bucket_count = histogram[i];
+            histogram[i] = offset;
+            offset += bucket_count;
+        }
+
+        for (umm i = 0; i < count; ++i) {
+            Sort_Entry entry = src[i];
+            dst[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+
+        Sort_Entry *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    return src;
+}
+
+template<typename T>
 function void
-renderer_bubblesort() {
-    umm length = g_renderer->sort_keys.count;
-    b32 terminate = false;
-    while (!terminate) {
-        terminate = true;
-        for (u32 i = 0; i < length - 1; ++i) {
-            u32 j = i + 1;
-            if (compare_sort_key(g_renderer->sort_keys.data[i], g_renderer->sort_keys.data[j])) {
-                Sort_Key ktmp = g_renderer->sort_keys.data[i];
-                g_renderer->sort_keys.data[i] = g_renderer->sort_keys.data[j];
-                g_renderer->sort_keys.data[j] = ktmp;
-
-                for (u32 k = 0; k < 3; ++k) {
-                    Vertex vtmp = g_renderer->vertices.data[3*i + k];
-                    g_renderer->vertices.data[3*i + k] = g_renderer->vertices.data[3*j + k];
-                    g_renderer->vertices.data[3*j + k] = vtmp;
-                }
-                terminate = false;
-            }
+renderer_fit_scratch(Dynamic_Array<T> *array, umm count) {
+    if (array->size < count) {
+        array->init(count);
+    }
+    array->count = count;
+}
+
+template<typename T>
+function void
+renderer_swap_arrays(Dynamic_Array<T> *a, Dynamic_Array<T> *b) {
+    Dynamic_Array<T> tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// @NOTE: Sorts (key, index) pairs only, then gathers the keys and their items
+// (items_per_key of them per key) once into the final order.
+template<typename T>
+function void
+renderer_sort_stream(Dynamic_Array<Sort_Key> *keys, Dynamic_Array<T> *items,
+                     Dynamic_Array<T> *items_scratch, u32 items_per_key) {
+    umm count = keys->count;
+    if (count == 0) {
+        return;
+    }
+    ASSERT(items->count == count*items_per_key);
+
+    renderer_fit_scratch(&g_renderer->sort_entries, count);
+    renderer_fit_scratch(&g_renderer->sort_entries_scratch, count);
+    renderer_fit_scratch(&g_renderer->sort_keys_scratch, count);
+    renderer_fit_scratch(items_scratch, count*items_per_key);
+
+    Sort_Key *src_keys = keys->data;
+    Sort_Entry *entries = g_renderer->sort_entries.data;
+    for (umm i = 0; i < count; ++i) {
+        entries[i].key   = sort_key_pack(src_keys[i]);
+        entries[i].index = (u32)i;
+    }
+
+    Sort_Entry *sorted = radix_sort(entries, g_renderer->sort_entries_scratch.data, count);
+
+    T *src_items = items->data;
+    T *dst_items = items_scratch->data;
+    Sort_Key *dst_keys = g_renderer->sort_keys_scratch.data;
+    for (umm i = 0; i < count; ++i) {
+        u32 index = sorted[i].index;
+        dst_keys[i] = src_keys[index];
+        for (u32 k = 0; k < items_per_key; ++k) {
+            dst_items[items_per_key*i + k] = src_items[items_per_key*index + k];
+        }
+    }
+
+    renderer_swap_arrays(keys, &g_renderer->sort_keys_scratch);
+    renderer_swap_arrays(items, items_scratch);
+}
+
+template<typename T>
+function void
+renderer_append_array(Dynamic_Array<T> *dst, Dynamic_Array<T> *src) {
+    dst->append(src->data, src->count);
+}
+
+// @NOTE: Appends src's keys to dst with their depth moved past everything in dst,
+// so submission order across lists is list order.
+function void
+renderer_append_sort_keys(Dynamic_Array<Sort_Key> *dst, Dynamic_Array<Sort_Key> *src, u32 depth_base) {
+    umm first = dst->count;
+    renderer_append_array(dst, src);
+    for (umm i = first; i < dst->count; ++i) {
+        dst->data[i].depth += depth_base;
+    }
+}
+
+// @NOTE: Moves every other thread's list onto the end of draw_lists[0]. Only call
+// once the threads are done pushing for the frame.
+function void
+renderer_merge_draw_lists(void) {
+    Draw_List *main = g_renderer->draw_lists;
+    for (u32 i = 1; i < RENDERER_DRAW_LIST_COUNT; ++i) {
+        Draw_List *list = g_renderer->draw_lists + i;
+        if (list->sort_sequence == 0 && list->cull_stats.tested == 0) {
+            continue;
         }
+
+        u32 depth_base = main->sort_sequence;
+        renderer_append_sort_keys(&main->sort_keys, &list->sort_keys, depth_base);
+        renderer_append_array(&main->vertices, &list->vertices);
+        renderer_append_sort_keys(&main->quad_sort_keys, &list->quad_sort_keys, depth_base);
+        renderer_append_array(&main->quad_vertices, &list->quad_vertices);
+        renderer_append_sort_keys(&main->compact_quad_sort_keys, &list->compact_quad_sort_keys, depth_base);
+        renderer_append_array(&main->compact_quad_vertices, &list->compact_quad_vertices);
+        renderer_append_sort_keys(&main->sprite_sort_keys, &list->sprite_sort_keys, depth_base);
+        renderer_append_array(&main->sprites, &list->sprites);
+        renderer_append_sort_keys(&main->static_sort_keys, &list->static_sort_keys, depth_base);
+        renderer_append_array(&main->static_draws, &list->static_draws);
+        main->sort_sequence += list->sort_sequence;
+        main->cull_stats.tested += list->cull_stats.tested;
+        main->cull_stats.culled += list->cull_stats.culled;
+
+        renderer_clear_draw_list(list);
     }
 }
 
 function void
-renderer_fill_drawcall_vertex_count() {
-    u32 current_end = 0;
-    Sort_Key current_sort_key = g_renderer->sort_keys.data[0];
+renderer_sort() {
+    renderer_merge_draw_lists();
+
+    Draw_List *list = g_renderer->draw_lists;
+    renderer_sort_stream(&list->sort_keys, &list->vertices, &g_renderer->vertices_scratch, 3);
+    renderer_sort_stream(&list->quad_sort_keys, &list->quad_vertices, &g_renderer->quad_vertices_scratch, 4);
+    renderer_sort_stream(&list->compact_quad_sort_keys, &list->compact_quad_vertices,
+                         &g_renderer->compact_quad_vertices_scratch, 4);
+    renderer_sort_stream(&list->sprite_sort_keys, &list->sprites, &g_renderer->sprites_scratch, 1);
+    renderer_sort_stream(&list->static_sort_keys, &list->static_draws, &g_renderer->static_draws_scratch, 1);
+}
+
+// @NOTE: Splits keys [first, end) of one sorted stream into batches wherever GPU
+// state changes. primitive_size is in the batch's unit (3 vertices per triangle,
+// 4 per quad, 1 instance per sprite).
+function void
+renderer_fill_stream_batches(Dynamic_Array<Render_Batch> *batches, Sort_Key *keys, umm first, umm end,
+                             Render_Batch_Kind kind, u32 primitive_size) {
+    Render_Batch *current = 0;
+    for (umm i = first; i < end; ++i) {
+        Sort_Key sort_key = keys[i];
+        if (!current || !sort_key_same_state(current->sort_key, sort_key)) {
+            Render_Batch batch{};
+            batch.key       = sort_key_pack(sort_key);
+            batch.sort_key  = sort_key;
+            batch.kind      = kind;
+            batch.first     = (u32)i*primitive_size;
+            batches->push(batch);
+            current = batches->data + batches->count - 1;
+        }
+        current->count += primitive_size;
+    }
+}
 
-    for (u32 i = 0; i < g_renderer->sort_keys.count; ++i) {
-        if (!sort_key_is_same(current_sort_key, g_renderer->sort_keys.data[i])) {
-            current_sort_key = g_renderer->sort_keys.data[i];
-            u32 numtri = i - current_end;
-            g_renderer->drawcall_vertex_count.push(3*numtri);
-            current_end = i;
+// @NOTE: Each static draw has its own vertex buffer, so it's always its own batch.
+function Render_Batch
+renderer_static_draw_batch(Draw_List *list, umm index) {
+    Static_Batch_Data *data = renderer_get_static_batch(list->static_draws.data[index]);
+    Render_Batch result{};
+    result.sort_key = list->static_sort_keys.data[index];
+    result.key      = sort_key_pack(result.sort_key);
+    result.kind     = RENDER_BATCH_STATIC;
+    result.first    = list->static_draws.data[index].id;
+    result.count    = (u32)data->vertices.count;
+    return result;
+}
+
+// @NOTE: Index of the first translucent key; they sort after every opaque one.
+function umm
+renderer_first_translucent(Dynamic_Array<Sort_Key> *keys) {
+    umm lo = 0;
+    umm hi = keys->count;
+    while (lo < hi) {
+        umm mid = lo + (hi - lo)/2;
+        if (keys->data[mid].translucent) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
         }
     }
+    return lo;
+}
 
-    u32 numtri = (u32)g_renderer->sort_keys.count - current_end;
-    g_renderer->drawcall_vertex_count.push(3*numtri);
+// @NOTE: Opaque draws are depth tested, so only state matters: each stream is
+// batched on its own and the batches are merged by the key of their first
+// primitive. Translucent draws keep painter's order, so the streams' translucent
+// tails are merged primitive by primitive by key, which orders them by layer and
+// depth, and a batch only runs while consecutive primitives come from the same
+// stream with the same state. Ties go to the stream listed first in
+// Render_Batch_Kind.
+function void
+renderer_fill_batches() {
+    Dynamic_Array<Render_Batch> *unmerged = &g_renderer->batches_scratch;
+    Dynamic_Array<Render_Batch> *merged   = &g_renderer->batches;
+    unmerged->clear();
+    merged->clear();
+
+    Draw_List *list = g_renderer->draw_lists;
+    Dynamic_Array<Sort_Key> *stream_keys[RENDER_BATCH_KIND_COUNT] = {
+        &list->sort_keys, &list->quad_sort_keys, &list->compact_quad_sort_keys,
+        &list->sprite_sort_keys, &list->static_sort_keys,
+    };
+    u32 primitive_sizes[RENDER_BATCH_KIND_COUNT] = {3, 4, 4, 1, 0};
+    umm translucent_first[RENDER_BATCH_KIND_COUNT];
+    for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+        translucent_first[k] = renderer_first_translucent(stream_keys[k]);
+    }
+
+    umm stream_end[RENDER_BATCH_KIND_COUNT];
+    for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+        if (k == RENDER_BATCH_STATIC) {
+            for (umm i = 0; i < translucent_first[k]; ++i) {
+                unmerged->push(renderer_static_draw_batch(list, i));
+            }
+        } else {
+            renderer_fill_stream_batches(unmerged, stream_keys[k]->data, 0, translucent_first[k],
+                                         (Render_Batch_Kind)k, primitive_sizes[k]);
+        }
+        stream_end[k] = unmerged->count;
+    }
+
+    umm head[RENDER_BATCH_KIND_COUNT];
+    for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+        head[k] = (k == 0) ? 0 : stream_end[k - 1];
+    }
+
+    for (;;) {
+        s32 next = -1;
+        for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+            if (head[k] < stream_end[k] &&
+                (next < 0 || unmerged->data[head[k]].key < unmerged->data[head[next]].key)) {
+                next = k;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        merged->push(unmerged->data[head[next]++]);
+    }
+
+    u64 head_key[RENDER_BATCH_KIND_COUNT];
+    for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+        head[k] = translucent_first[k];
+        if (head[k] < stream_keys[k]->count) {
+            head_key[k] = sort_key_pack(stream_keys[k]->data[head[k]]);
+        }
+    }
+
+    s32 last = -1;
+    for (;;) {
+        s32 next = -1;
+        for (u32 k = 0; k < RENDER_BATCH_KIND_COUNT; ++k) {
+            if (head[k] < stream_keys[k]->count && (next < 0 || head_key[k] < head_key[next])) {
+                next = k;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        umm i = head[next];
+        Sort_Key sort_key = stream_keys[next]->data[i];
+        if (next == RENDER_BATCH_STATIC) {
+            merged->push(renderer_static_draw_batch(list, i));
+        } else {
+            Render_Batch *current = merged->count ? merged->data + merged->count - 1 : 0;
+            if (last == next && sort_key_same_state(current->sort_key, sort_key)) {
+                current->count += primitive_sizes[next];
+            } else {
+                Render_Batch batch{};
+                batch.key       = head_key[next];
+                batch.sort_key  = sort_key;
+                batch.kind      = (Render_Batch_Kind)next;
+                batch.first     = (u32)i*primitive_sizes[next];
+                batch.count     = primitive_sizes[next];
+                merged->push(batch);
+            }
+        }
+        last = next;
+
+        if (++head[next] < stream_keys[next]->count) {
+            head_key[next] = sort_key_pack(stream_keys[next]->data[head[next]]);
+        }
+    }
 }
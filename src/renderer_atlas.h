@@ -0,0 +1,144 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+// @NOTE: Skyline bottom-left packer for one square atlas page. The skyline is the
+// top edge of everything placed so far, as horizontal segments sorted by x.
+// A rect goes where its top ends up lowest (ties: narrowest segment). Nothing is
+// ever freed; a page is done when it's full.
+#ifndef ATLAS_PAGE_DIM
+#  define ATLAS_PAGE_DIM 2048
+#endif
+static_assert(ATLAS_PAGE_DIM <= 0xFFFF, "Atlas segments are stored as u16.");
+
+struct Atlas_Segment {
+    u16 x;
+    u16 y;
+    u16 width;
+};
+
+struct Atlas_Page {
+    u32 slot;
+    u32 segment_count;
+    u32 used_area;
+    Atlas_Segment segments[ATLAS_PAGE_DIM];
+};
+
+function void
+atlas_page_init(Atlas_Page *page, u32 slot) {
+    page->slot                  = slot;
+    page->segment_count         = 1;
+    page->used_area             = 0;
+    page->segments[0].x         = 0;
+    page->segments[0].y         = 0;
+    page->segments[0].width     = ATLAS_PAGE_DIM;
+}
+
+// @NOTE: Where the bottom of a width*height rect would sit if its left edge is at
+// segment index. Fails if it sticks out of the page.
+function b32
+atlas_page_fit(Atlas_Page *page, u32 index, u32 width, u32 height, u32 *out_y) {
+    u32 x = page->segments[index].x;
+    if (x + width > ATLAS_PAGE_DIM) {
+        return false;
+    }
+
+    u32 y = 0;
+    s32 width_left = (s32)width;
+    for (u32 i = index; width_left > 0; ++i) {
+        ASSERT(i < page->segment_count);
+        y = MAX(y, (u32)page->segments[i].y);
+        if (y + height > ATLAS_PAGE_DIM) {
+            return false;
+        }
+        width_left -= page->segments[i].width;
+    }
+
+    *out_y = y;
+    return true;
+}
+
+function b32
+atlas_page_pack(Atlas_Page *page, u32 width, u32 height, u32 *out_x, u32 *out_y) {
+    ASSERT(width > 0 && height > 0);
+
+    u32 best_index  = (u32)-1;
+    u32 best_top    = (u32)-1;
+    u32 best_width  = (u32)-1;
+    u32 best_y      = 0;
+    for (u32 i = 0; i < page->segment_count; ++i) {
+        u32 y;
+        if (atlas_page_fit(page, i, width, height, &y)) {
+            u32 top = y + height;
+            if (top < best_top || (top == best_top && page->segments[i].width < best_width)) {
+                best_index = i;
+                best_top   = top;
+                best_width = page->segments[i].width;
+                best_y     = y;
+            }
+        }
+    }
+
+    if (best_index == (u32)-1) {
+        return false;
+    }
+
+    // Insert the new segment on top of the rect.
+    ASSERT(page->segment_count < ATLAS_PAGE_DIM);
+    Atlas_Segment *segments = page->segments;
+    for (u32 i = page->segment_count; i > best_index; --i) {
+        segments[i] = segments[i - 1];
+    }
+    segments[best_index].x      = segments[best_index + 1].x;
+    segments[best_index].y      = (u16)(best_y + height);
+    segments[best_index].width  = (u16)width;
+    ++page->segment_count;
+    u32 x = segments[best_index].x;
+
+    // Trim or drop the segments it now covers.
+    for (u32 i = best_index + 1; i < page->segment_count; ++i) {
+        Atlas_Segment *prev = segments + i - 1;
+        u32 prev_right = (u32)prev->x + prev->width;
+        if (segments[i].x >= prev_right) {
+            break;
+        }
+
+        u32 shrink = prev_right - segments[i].x;
+        if (shrink < segments[i].width) {
+            segments[i].x       = (u16)(segments[i].x + shrink);
+            segments[i].width   = (u16)(segments[i].width - shrink);
+            break;
+        }
+
+        for (u32 j = i; j + 1 < page->segment_count; ++j) {
+            segments[j] = segments[j + 1];
+        }
+        --page->segment_count;
+        --i;
+    }
+
+    // Merge neighbours at the same height.
+    for (u32 i = 0; i + 1 < page->segment_count;) {
+        if (segments[i].y == segments[i + 1].y) {
+            segments[i].width = (u16)(segments[i].width + segments[i + 1].width);
+            for (u32 j = i + 1; j + 1 < page->segment_count; ++j) {
+                segments[j] = segments[j + 1];
+            }
+            --page->segment_count;
+        } else {
+            ++i;
+        }
+    }
+
+    page->used_area += width*height;
+    *out_x = x;
+    *out_y = best_y;
+    return true;
+}
@@ -0,0 +1,234 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+// @NOTE: Frame capture. Each captured frame is what the backend got handed at end
+// of frame: the swapchain extent, the camera and view, texture uploads (with their pixels)
+// and destroys, static batches that changed, the frame's clips, and the sorted
+// streams of draw_lists[0]. Batches aren't stored; replay rebuilds them.
+//
+// Layout, all little endian:
+//   Capture_File_Header
+//   per frame:
+//     Capture_Frame_Header
+//     upload_count       x (Capture_Upload, width*height*4 bytes of pixels unless ATLAS_PAGE)
+//     destroy_count      x u32 image id
+//     static_batch_count x (Capture_Static_Batch, vertex_count Vertex)
+//     clip_count Renderer_Clip, clip_mask_vertex_count Vertex
+//     the streams as raw arrays: triangle Sort_Key + 3 Vertex each, quad Sort_Key + 4 Vertex,
+//     compact quad Sort_Key + 4 Vertex_Compact, sprite Sort_Key + Sprite_Instance,
+//     static draw Sort_Key + Static_Batch.
+// Structs are written raw, so a capture only replays where they have the same
+// layout; bump the version whenever one changes.
+#define RENDERER_CAPTURE_MAGIC      0x50434B56      // "VKCP"
+#define RENDERER_CAPTURE_VERSION    3
+
+struct Capture_File_Header {
+    u32 magic;
+    u32 version;
+    u32 frame_count;
+    u32 reserved;
+};
+
+struct Capture_Frame_Header {
+    u32 width;
+    u32 height;
+    b32 has_camera;
+    m4x4 camera;
+    b32 has_view;
+    Rect2 cull_rect;
+    b32 gpu_cull_sprites;
+
+    u32 upload_count;
+    u32 destroy_count;
+    u32 static_batch_count;
+    u32 clip_count;
+    u32 clip_mask_count;
+    u32 clip_mask_vertex_count;
+
+    u32 triangle_count;
+    u32 quad_count;
+    u32 compact_quad_count;
+    u32 sprite_count;
+    u32 static_draw_count;
+};
+
+struct Capture_Upload {
+    u32 kind;
+    u32 image_id;
+    u32 width;
+    u32 height;
+    u32 slot;
+    u32 page;
+    u32 x;
+    u32 y;
+};
+
+struct Capture_Static_Batch {
+    u32 id;
+    b32 used;
+    b32 opaque;
+    u32 vertex_count;
+    Rect2 bounds;
+};
+
+// @NOTE: Captures the next frame_count frames (0 = until renderer_end_capture).
+// Only texture uploads queued while capturing are recorded, and their pixels
+// aren't kept afterwards, so this has to be called at startup, before the first
+// image is registered; otherwise replay would draw from slots and atlas regions it
+// never uploaded.
+function b32
+renderer_begin_capture(const char *path, u32 frame_count) {
+    Renderer_Capture *capture = &g_renderer->capture;
+    ASSERT(!capture->file);
+    spin_lock(&g_renderer->image_lock);
+    ASSERT(g_renderer->texture_slot_count == 0 && g_renderer->atlas_page_count == 0);
+    spin_unlock(&g_renderer->image_lock);
+
+    capture->file = fopen(path, "wb");
+    if (!capture->file) {
+        fprintf(stderr, "[ERROR] Couldn't open capture file %s.\n", path);
+        return false;
+    }
+    capture->frames_left = frame_count;
+    capture->frame_count = 0;
+    for (u32 i = 0; i < RENDERER_STATIC_BATCH_COUNT; ++i) {
+        capture->static_generations[i] = (u32)-1;
+    }
+
+    Capture_File_Header header{};
+    header.magic   = RENDERER_CAPTURE_MAGIC;
+    header.version = RENDERER_CAPTURE_VERSION;
+    fwrite(&header, sizeof(header), 1, capture->file);
+    return true;
+}
+
+function void
+renderer_end_capture(void) {
+    Renderer_Capture *capture = &g_renderer->capture;
+    if (!capture->file) {
+        return;
+    }
+
+    Capture_File_Header header{};
+    header.magic       = RENDERER_CAPTURE_MAGIC;
+    header.version     = RENDERER_CAPTURE_VERSION;
+    header.frame_count = capture->frame_count;
+    fseek(capture->file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, capture->file);
+    fclose(capture->file);
+    capture->file = 0;
+}
+
+template<typename T>
+function void
+renderer_capture_array(FILE *file, Dynamic_Array<T> *array) {
+    if (array->count) {
+        fwrite(array->data, sizeof(T), array->count, file);
+    }
+}
+
+// @NOTE: Called by the platform layer at end of frame, before the backend drains
+// the upload queues.
+function void
+renderer_capture_frame(u32 width, u32 height) {
+    Renderer_Capture *capture = &g_renderer->capture;
+    if (!capture->file) {
+        return;
+    }
+
+    FILE *file = capture->file;
+    Draw_List *list = g_renderer->draw_lists;
+    Chunked_Queue<Texture_Upload> *uploads = &g_renderer->image_create_queue;
+    Chunked_Queue<u32> *destroys = &g_renderer->image_destroy_queue;
+
+    u32 static_batch_count = 0;
+    for (u32 i = 0; i < g_renderer->static_batch_count; ++i) {
+        static_batch_count += (g_renderer->static_batches[i].generation != capture->static_generations[i]);
+    }
+
+    Capture_Frame_Header header{};
+    header.width                  = width;
+    header.height                 = height;
+    header.has_camera             = g_renderer->has_camera;
+    header.camera                 = g_renderer->camera;
+    header.has_view               = g_renderer->has_view;
+    header.cull_rect              = g_renderer->cull_rect;
+    header.gpu_cull_sprites       = g_renderer->gpu_cull_sprites;
+    header.upload_count           = uploads->count();
+    header.destroy_count          = destroys->count();
+    header.static_batch_count     = static_batch_count;
+    header.clip_count             = g_renderer->clip_count;
+    header.clip_mask_count        = g_renderer->clip_mask_count;
+    header.clip_mask_vertex_count = (u32)g_renderer->clip_mask_vertices.count;
+    header.triangle_count         = (u32)list->sort_keys.count;
+    header.quad_count             = (u32)list->quad_sort_keys.count;
+    header.compact_quad_count     = (u32)list->compact_quad_sort_keys.count;
+    header.sprite_count           = (u32)list->sprite_sort_keys.count;
+    header.static_draw_count      = (u32)list->static_sort_keys.count;
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (u32 i = 0; i < header.upload_count; ++i) {
+        Texture_Upload upload = *uploads->peek(i);
+        Capture_Upload record{};
+        record.kind     = upload.kind;
+        record.image_id = upload.image.id;
+        record.width    = upload.image.width;
+        record.height   = upload.image.height;
+        record.slot     = upload.slot;
+        record.page     = upload.page;
+        record.x        = upload.x;
+        record.y        = upload.y;
+        fwrite(&record, sizeof(record), 1, file);
+        if (upload.kind != TEXTURE_UPLOAD_ATLAS_PAGE) {
+            fwrite(upload.image.data, 4, upload.image.width*upload.image.height, file);
+        }
+    }
+
+    for (u32 i = 0; i < header.destroy_count; ++i) {
+        u32 image_id = *destroys->peek(i);
+        fwrite(&image_id, sizeof(image_id), 1, file);
+    }
+
+    for (u32 i = 0; i < g_renderer->static_batch_count; ++i) {
+        Static_Batch_Data *data = g_renderer->static_batches + i;
+        if (data->generation == capture->static_generations[i]) {
+            continue;
+        }
+        Capture_Static_Batch record{};
+        record.id           = i + 1;
+        record.used         = data->used;
+        record.opaque       = data->opaque;
+        record.vertex_count = (u32)data->vertices.count;
+        record.bounds       = data->bounds;
+        fwrite(&record, sizeof(record), 1, file);
+        renderer_capture_array(file, &data->vertices);
+        capture->static_generations[i] = data->generation;
+    }
+
+    fwrite(g_renderer->clips, sizeof(Renderer_Clip), g_renderer->clip_count, file);
+    renderer_capture_array(file, &g_renderer->clip_mask_vertices);
+
+    renderer_capture_array(file, &list->sort_keys);
+    renderer_capture_array(file, &list->vertices);
+    renderer_capture_array(file, &list->quad_sort_keys);
+    renderer_capture_array(file, &list->quad_vertices);
+    renderer_capture_array(file, &list->compact_quad_sort_keys);
+    renderer_capture_array(file, &list->compact_quad_vertices);
+    renderer_capture_array(file, &list->sprite_sort_keys);
+    renderer_capture_array(file, &list->sprites);
+    renderer_capture_array(file, &list->static_sort_keys);
+    renderer_capture_array(file, &list->static_draws);
+
+    ++capture->frame_count;
+    if (capture->frames_left && --capture->frames_left == 0) {
+        renderer_end_capture();
+    }
+}
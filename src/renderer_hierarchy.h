@@ -0,0 +1,405 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+// @NOTE: 2D transform hierarchy. Nodes live in flat arrays, one per field, kept
+// in pre-order (every node followed by its whole subtree), so one forward pass
+// over the arrays propagates transforms without recursion or pointer chasing, and
+// draws each subtree as a unit.
+//
+// Local transforms are TRS built with trs_to_transform(); world = parent world *
+// local. Setters only flag the node, and update_hierarchy() recomputes the world
+// transforms (and cached quad corners) of flagged nodes and their subtrees only.
+// A hierarchy that didn't change costs nothing to update, and drawing it is a
+// cull and a push per sprite. Parts that never move can be drawn once inside
+// begin_static_batch()/end_static_batch() and then cost one draw per frame.
+//
+// Creating nodes mostly keeps the order for free: appending a root, or a child of
+// the last node or one of its ancestors, is still pre-order. Anything else, and
+// reparenting and destroying, flags the hierarchy and the next update re-sorts it.
+#define HIERARCHY_NONE  0xFFFFFFFF
+
+enum {
+    NODE_LOCAL_DIRTY    = 0x1,      // local TRS changed
+    NODE_WORLD_DIRTY    = 0x2,      // parent or sprite changed
+    NODE_UPDATED        = 0x4,      // world recomputed by the running update
+    NODE_DESTROYED      = 0x8,
+    NODE_HAS_SPRITE     = 0x10,
+};
+
+// @NOTE: Handle; id 0 is no node, so a zeroed Transform_Node is a root's parent.
+struct Transform_Node {
+    u32 id;
+};
+
+struct Node_Sprite {
+    Image image;
+    v2 dim;             // local units, centered on the node
+    v4 color;
+};
+
+// @NOTE: World space corners of a node's sprite in index pattern order, and their
+// bounds for culling. Only rebuilt when the world transform is.
+struct Node_Quad {
+    v2 corners[4];
+    Rect2 bounds;
+};
+
+struct Transform_Hierarchy {
+    // Per node, in pre-order.
+    Dynamic_Array<u32> parents;             // index, or HIERARCHY_NONE
+    Dynamic_Array<u32> ids;
+    Dynamic_Array<u32> flags;
+    Dynamic_Array<v2> translations;
+    Dynamic_Array<f32> rotations;           // radians, counter-clockwise
+    Dynamic_Array<v2> scales;
+    Dynamic_Array<m4x4> locals;
+    Dynamic_Array<m4x4> worlds;
+    Dynamic_Array<Node_Sprite> sprites;
+    Dynamic_Array<Node_Quad> quads;
+
+    // By id - 1.
+    Dynamic_Array<u32> indices;             // HIERARCHY_NONE once destroyed
+    Dynamic_Array<u32> free_ids;
+
+    u32 dirty_count;
+    b32 needs_sort;
+
+    // Re-sort scratch.
+    Dynamic_Array<u32> offsets;
+    Dynamic_Array<u32> children;
+    Dynamic_Array<u32> order;
+    Dynamic_Array<u32> remap;
+    Dynamic_Array<u32> stack;
+    Dynamic_Array<u8> scratch;
+};
+
+function u32
+hierarchy_index(Transform_Hierarchy *h, Transform_Node node) {
+    ASSERT(node.id > 0 && node.id <= h->indices.count);
+    u32 index = h->indices.data[node.id - 1];
+    ASSERT(index != HIERARCHY_NONE);
+    return index;
+}
+
+function void
+hierarchy_mark_dirty(Transform_Hierarchy *h, u32 index, u32 flag) {
+    h->flags.data[index] |= flag;
+    ++h->dirty_count;
+}
+
+function Transform_Node
+create_node(Transform_Hierarchy *h, Transform_Node parent) {
+    u32 parent_index = parent.id ? hierarchy_index(h, parent) : HIERARCHY_NONE;
+
+    // @NOTE: Walks up from the last node, so it's O(depth).
+    if (parent_index != HIERARCHY_NONE) {
+        u32 at = (u32)h->parents.count - 1;
+        while (at != HIERARCHY_NONE && at != parent_index) {
+            at = h->parents.data[at];
+        }
+        if (at == HIERARCHY_NONE) {
+            h->needs_sort = true;
+        }
+    }
+
+    Transform_Node result{};
+    if (h->free_ids.count) {
+        result.id = h->free_ids.data[--h->free_ids.count];
+    } else {
+        h->indices.push(HIERARCHY_NONE);
+        result.id = (u32)h->indices.count;
+    }
+
+    u32 index = (u32)h->parents.count;
+    h->indices.data[result.id - 1] = index;
+
+    h->parents.push(parent_index);
+    h->ids.push(result.id);
+    h->flags.push(NODE_LOCAL_DIRTY);
+    h->translations.push(v2{0, 0});
+    h->rotations.push(0.0f);
+    h->scales.push(v2{1, 1});
+    h->locals.push(identity());
+    h->worlds.push(identity());
+    h->sprites.push(Node_Sprite{});
+    h->quads.push(Node_Quad{});
+    ++h->dirty_count;
+
+    return result;
+}
+
+// @NOTE: Destroys node and its whole subtree. Storage is reclaimed on the next
+// update.
+function void
+destroy_node(Transform_Hierarchy *h, Transform_Node node) {
+    u32 index = hierarchy_index(h, node);
+    h->flags.data[index] |= NODE_DESTROYED;
+    h->needs_sort = true;
+}
+
+function void
+set_node_parent(Transform_Hierarchy *h, Transform_Node node, Transform_Node parent) {
+    u32 index = hierarchy_index(h, node);
+    u32 parent_index = HIERARCHY_NONE;
+    if (parent.id) {
+        parent_index = hierarchy_index(h, parent);
+        // @NOTE: No cycles; walks up from the new parent, so it's O(depth).
+        for (u32 at = parent_index; at != HIERARCHY_NONE; at = h->parents.data[at]) {
+            ASSERT(at != index);
+        }
+    }
+
+    if (h->parents.data[index] != parent_index) {
+        h->parents.data[index] = parent_index;
+        hierarchy_mark_dirty(h, index, NODE_WORLD_DIRTY);
+        h->needs_sort = true;
+    }
+}
+
+function void
+set_node_trs(Transform_Hierarchy *h, Transform_Node node, v2 translation, f32 rotation, v2 scale) {
+    u32 index = hierarchy_index(h, node);
+    h->translations.data[index] = translation;
+    h->rotations.data[index]    = rotation;
+    h->scales.data[index]       = scale;
+    hierarchy_mark_dirty(h, index, NODE_LOCAL_DIRTY);
+}
+
+function void
+set_node_translation(Transform_Hierarchy *h, Transform_Node node, v2 translation) {
+    u32 index = hierarchy_index(h, node);
+    h->translations.data[index] = translation;
+    hierarchy_mark_dirty(h, index, NODE_LOCAL_DIRTY);
+}
+
+function void
+set_node_rotation(Transform_Hierarchy *h, Transform_Node node, f32 rotation) {
+    u32 index = hierarchy_index(h, node);
+    h->rotations.data[index] = rotation;
+    hierarchy_mark_dirty(h, index, NODE_LOCAL_DIRTY);
+}
+
+// @NOTE: Gives node a quad of dim (local units) centered on it. A zero dim
+// removes it.
+function void
+set_node_sprite(Transform_Hierarchy *h, Transform_Node node, Image image, v2 dim, v4 color) {
+    u32 index = hierarchy_index(h, node);
+    Node_Sprite *sprite = h->sprites.data + index;
+    sprite->image = image;
+    sprite->dim   = dim;
+    sprite->color = color;
+    if (dim.x != 0.0f && dim.y != 0.0f) {
+        h->flags.data[index] |= NODE_HAS_SPRITE;
+    } else {
+        h->flags.data[index] &= ~NODE_HAS_SPRITE;
+    }
+    // @NOTE: The corners scale with dim, so they have to be rebuilt.
+    hierarchy_mark_dirty(h, index, NODE_WORLD_DIRTY);
+}
+
+// @NOTE: Moves every per-node array into the order given by order[new index] =
+// old index.
+template<typename T>
+function void
+hierarchy_permute(Transform_Hierarchy *h, Dynamic_Array<T> *array, u32 *order, u32 count) {
+    renderer_fit_scratch(&h->scratch, sizeof(T)*count);
+    T *tmp = (T *)h->scratch.data;
+    for (u32 i = 0; i < count; ++i) {
+        tmp[i] = array->data[order[i]];
+    }
+    copy_array(tmp, array->data, count);
+    array->count = count;
+}
+
+// @NOTE: Re-establishes pre-order after edits and drops destroyed subtrees.
+// Roots, and the children of each node, keep their current relative order.
+function void
+hierarchy_sort(Transform_Hierarchy *h) {
+    u32 count = (u32)h->parents.count;
+
+    // @NOTE: Each node's children, by index, are children[offsets[node]] up to
+    // children[offsets[node + 1]]; roots are filed under count. Filled back to
+    // front, so offsets ends up at each range's start.
+    renderer_fit_scratch(&h->offsets, count + 2);
+    u32 *offsets = h->offsets.data;
+    for (u32 i = 0; i < count + 2; ++i) {
+        offsets[i] = 0;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        u32 parent = h->parents.data[i];
+        ++offsets[(parent == HIERARCHY_NONE) ? count : parent];
+    }
+    for (u32 i = 1; i < count + 2; ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    renderer_fit_scratch(&h->children, count);
+    u32 *children = h->children.data;
+    for (u32 i = count; i > 0; --i) {
+        u32 parent = h->parents.data[i - 1];
+        children[--offsets[(parent == HIERARCHY_NONE) ? count : parent]] = i - 1;
+    }
+
+    // @NOTE: Depth-first, children pushed in reverse so they come off in order.
+    // Destroyed nodes aren't entered, which leaves their subtrees out as well.
+    renderer_fit_scratch(&h->order, count);
+    u32 *order = h->order.data;
+    u32 live_count = 0;
+    h->stack.clear();
+    for (u32 c = offsets[count + 1]; c > offsets[count]; --c) {
+        h->stack.push(children[c - 1]);
+    }
+    while (h->stack.count) {
+        u32 node = h->stack.data[--h->stack.count];
+        if (h->flags.data[node] & NODE_DESTROYED) {
+            continue;
+        }
+        order[live_count++] = node;
+        for (u32 c = offsets[node + 1]; c > offsets[node]; --c) {
+            h->stack.push(children[c - 1]);
+        }
+    }
+
+    // @NOTE: remap is old index -> new index, HIERARCHY_NONE for dropped nodes.
+    renderer_fit_scratch(&h->remap, count);
+    u32 *remap = h->remap.data;
+    for (u32 i = 0; i < count; ++i) {
+        remap[i] = HIERARCHY_NONE;
+    }
+    for (u32 i = 0; i < live_count; ++i) {
+        remap[order[i]] = i;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        if (remap[i] == HIERARCHY_NONE) {
+            u32 id = h->ids.data[i];
+            h->indices.data[id - 1] = HIERARCHY_NONE;
+            h->free_ids.push(id);
+            continue;
+        }
+        u32 parent = h->parents.data[i];
+        if (parent != HIERARCHY_NONE) {
+            h->parents.data[i] = remap[parent];
+        }
+    }
+
+    hierarchy_permute(h, &h->parents, order, live_count);
+    hierarchy_permute(h, &h->ids, order, live_count);
+    hierarchy_permute(h, &h->flags, order, live_count);
+    hierarchy_permute(h, &h->translations, order, live_count);
+    hierarchy_permute(h, &h->rotations, order, live_count);
+    hierarchy_permute(h, &h->scales, order, live_count);
+    hierarchy_permute(h, &h->locals, order, live_count);
+    hierarchy_permute(h, &h->worlds, order, live_count);
+    hierarchy_permute(h, &h->sprites, order, live_count);
+    hierarchy_permute(h, &h->quads, order, live_count);
+
+    for (u32 i = 0; i < live_count; ++i) {
+        h->indices.data[h->ids.data[i] - 1] = i;
+    }
+    h->needs_sort = false;
+}
+
+function void
+hierarchy_build_quad(Node_Quad *quad, m4x4 *world, v2 dim) {
+    // @NOTE: The world transform's x and y columns, scaled to half the sprite,
+    // span the quad; its translation is the center.
+    v2 center = v2{world->e[0][3], world->e[1][3]};
+    v2 x_axis = 0.5f*dim.x*v2{world->e[0][0], world->e[1][0]};
+    v2 y_axis = 0.5f*dim.y*v2{world->e[0][1], world->e[1][1]};
+
+    quad->corners[0] = center - x_axis + y_axis;
+    quad->corners[1] = center + x_axis + y_axis;
+    quad->corners[2] = center - x_axis - y_axis;
+    quad->corners[3] = center + x_axis - y_axis;
+
+    v2 extent = v2{absolute(x_axis.x) + absolute(y_axis.x), absolute(x_axis.y) + absolute(y_axis.y)};
+    quad->bounds = rect2_cen_half_dim(center, extent);
+}
+
+// @NOTE: Recomputes world transforms of dirty nodes and everything under them.
+// A node is recomputed if it was flagged or its parent was recomputed earlier in
+// this same pass, which the pre-order guarantees.
+function void
+update_hierarchy(Transform_Hierarchy *h) {
+    if (h->needs_sort) {
+        hierarchy_sort(h);
+    }
+    if (h->dirty_count == 0) {
+        return;
+    }
+
+    u32 count = (u32)h->parents.count;
+    u32 *parents = h->parents.data;
+    u32 *flags = h->flags.data;
+    for (u32 i = 0; i < count; ++i) {
+        u32 node_flags = flags[i] & ~NODE_UPDATED;
+        u32 parent = parents[i];
+        b32 parent_updated = (parent != HIERARCHY_NONE && (flags[parent] & NODE_UPDATED));
+        if (!(node_flags & (NODE_LOCAL_DIRTY|NODE_WORLD_DIRTY)) && !parent_updated) {
+            flags[i] = node_flags;
+            continue;
+        }
+
+        if (node_flags & NODE_LOCAL_DIRTY) {
+            v2 t = h->translations.data[i];
+            v2 s = h->scales.data[i];
+            h->locals.data[i] = trs_to_transform(v3{t.x, t.y, 0.0f},
+                                                 build_quaternion(v3{0, 0, 1}, h->rotations.data[i]),
+                                                 v3{s.x, s.y, 1.0f});
+        }
+
+        m4x4 *world = h->worlds.data + i;
+        if (parent == HIERARCHY_NONE) {
+            *world = h->locals.data[i];
+        } else {
+            *world = h->worlds.data[parent] * h->locals.data[i];
+        }
+
+        if (node_flags & NODE_HAS_SPRITE) {
+            hierarchy_build_quad(h->quads.data + i, world, h->sprites.data[i].dim);
+        }
+
+        flags[i] = (node_flags & ~(NODE_LOCAL_DIRTY|NODE_WORLD_DIRTY)) | NODE_UPDATED;
+    }
+    h->dirty_count = 0;
+}
+
+function m4x4
+get_node_world(Transform_Hierarchy *h, Transform_Node node) {
+    update_hierarchy(h);
+    return h->worlds.data[hierarchy_index(h, node)];
+}
+
+// @NOTE: Updates, then draws every node's sprite with the current layer and clip.
+// Sprites go out in pre-order, so on a translucent layer children draw over their
+// parents and a subtree never interleaves with another.
+function void
+draw_hierarchy(Transform_Hierarchy *h) {
+    update_hierarchy(h);
+
+    u32 count = (u32)h->parents.count;
+    for (u32 i = 0; i < count; ++i) {
+        if (!(h->flags.data[i] & NODE_HAS_SPRITE)) {
+            continue;
+        }
+        Node_Quad *quad = h->quads.data + i;
+        if (renderer_cull(quad->bounds)) {
+            continue;
+        }
+
+        Node_Sprite *sprite = h->sprites.data + i;
+        Vertex v[4];
+        v[0] = {quad->corners[0], sprite->color, v2{0, 1}, 0};
+        v[1] = {quad->corners[1], sprite->color, v2{1, 1}, 0};
+        v[2] = {quad->corners[2], sprite->color, v2{0, 0}, 0};
+        v[3] = {quad->corners[3], sprite->color, v2{1, 0}, 0};
+        push_textured_quad(v, sprite->image);
+    }
+}
@@ -89,8 +89,8 @@ vk_query_physical_devices(VkInstance instance, VkPhysicalDevice *physical_device
 
 function void
 vk_sort_physical_devices(VkPhysicalDevice *physical_devices, u32 physical_device_count) {
-    s32 *scores = (s32 *)os.alloc(sizeof(s32)*physical_device_count);
-    SCOPE_EXIT(os.free(scores));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    s32 *scores = push_array(&renderer.frame_arena, s32, physical_device_count);
     zeroarray(scores, physical_device_count);
 
     for (u32 i = 0; i < physical_device_count; ++i) {
@@ -138,12 +138,11 @@ vk_create_device(Vulkan *vk) {
         total_queue_count += queue_families[i].queue_count;
     }
 
-    VkDeviceQueueCreateInfo *queue_create_infos = (VkDeviceQueueCreateInfo *)os.alloc(sizeof(VkDeviceQueueCreateInfo) * queue_create_info_count);
-    SCOPE_EXIT(os.free(queue_create_infos));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkDeviceQueueCreateInfo *queue_create_infos = push_array_zero(&renderer.frame_arena, VkDeviceQueueCreateInfo, queue_create_info_count);
 
     size_t priority_begin = 0;
-    float *priorities = (float *)os.alloc(sizeof(float) * total_queue_count);
-    SCOPE_EXIT(os.free(priorities));
+    float *priorities = push_array_zero(&renderer.frame_arena, float, total_queue_count);
 
     for (u32 i = 0; i < queue_create_info_count; ++i) {
         queue_create_infos[i].sType             = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -169,6 +168,12 @@ vk_create_device(Vulkan *vk) {
 
     vkGetPhysicalDeviceFeatures2(vk->physical_device, &vk->physical_device_features);
 
+    // @NOTE: The bindless texture array needs these; everything supported gets enabled below.
+    ASSERT(descriptor_indexing_feat.runtimeDescriptorArray);
+    ASSERT(descriptor_indexing_feat.descriptorBindingPartiallyBound);
+    ASSERT(descriptor_indexing_feat.descriptorBindingSampledImageUpdateAfterBind);
+    ASSERT(descriptor_indexing_feat.shaderSampledImageArrayNonUniformIndexing);
+
 
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType                    = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -334,6 +339,75 @@ vk_copy_to_buffer(Vulkan *vk, void *cpu_memory, VkDeviceSize offset, VkDeviceSiz
     vkUnmapMemory(vk->device, buffer_memory);
 }
 
+// @NOTE: Grows the device-local buffer to at least size, dropping its contents.
+// Only call this once the GPU is done with the buffer (after the in-flight fence).
+function void
+vk_fit_device_buffer(Vulkan *vk, VkBuffer *buffer, VkDeviceMemory *buffer_memory, VkDeviceSize *capacity,
+                     u32 usage, VkDeviceSize size) {
+    if (*capacity < size) {
+        vkDestroyBuffer(vk->device, *buffer, 0);
+        vkFreeMemory(vk->device, *buffer_memory, 0);
+        *capacity = MAX(size, 2*(*capacity));
+        vk_alloc_buffer(vk, buffer, buffer_memory, *capacity,
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+                        VK_SHARING_MODE_EXCLUSIVE,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
+
+// @NOTE: Grows the mapped buffer to at least size, dropping its contents. Only call
+// this once the GPU is done with the buffer (after the in-flight fence).
+function void
+vk_fit_mapped_buffer(Vulkan *vk, Vk_Mapped_Buffer *buffer, u32 usage, VkDeviceSize size) {
+    if (buffer->size < size) {
+        if (buffer->buffer) {
+            vkUnmapMemory(vk->device, buffer->memory);
+            vkDestroyBuffer(vk->device, buffer->buffer, 0);
+            vkFreeMemory(vk->device, buffer->memory, 0);
+        }
+        buffer->size = MAX(size, MAX(2*buffer->size, (VkDeviceSize)4096));
+        vk_alloc_buffer(vk, &buffer->buffer, &buffer->memory, buffer->size, usage,
+                        VK_SHARING_MODE_EXCLUSIVE,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        vkMapMemory(vk->device, buffer->memory, 0, buffer->size, 0, &buffer->mapped);
+    }
+}
+
+// @NOTE: Fits the mapped buffer, under the same rule, and writes data into it.
+function void
+vk_write_mapped_buffer(Vulkan *vk, Vk_Mapped_Buffer *buffer, u32 usage, void *data, VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+    vk_fit_mapped_buffer(vk, buffer, usage, size);
+    copy(data, buffer->mapped, size);
+}
+
+// @NOTE: Copies through a staging buffer, growing the device-local buffer first if it's
+// too small. Only call this once the GPU is done with the buffer (after the in-flight fence).
+function void
+vk_upload_to_device_buffer(Vulkan *vk, VkBuffer *buffer, VkDeviceMemory *buffer_memory, VkDeviceSize *capacity,
+                           u32 usage, void *data, VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+
+    vk_fit_device_buffer(vk, buffer, buffer_memory, capacity, usage, size);
+
+    VkBuffer staging_buffer{};
+    VkDeviceMemory staging_buffer_memory{};
+
+    vk_alloc_buffer(vk, &staging_buffer, &staging_buffer_memory, size,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_SHARING_MODE_EXCLUSIVE,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    SCOPE_EXIT(vkDestroyBuffer(vk->device, staging_buffer, 0));
+    SCOPE_EXIT(vkFreeMemory(vk->device, staging_buffer_memory, 0));
+
+    vk_copy_to_buffer(vk, data, 0, size, staging_buffer_memory);
+    vk_copy_buffer(vk, staging_buffer, *buffer, size);
+}
+
 function void
 vk_alloc_image(Vulkan *vk, VkImage *image, VkDeviceMemory *image_memory,
                u32 width, u32 height, VkFormat format, u32 usage) {
@@ -416,6 +490,11 @@ vk_image_transition(Vulkan *vk, VkImage image, VkImageLayout old_layout, VkImage
             src_stage               = VK_PIPELINE_STAGE_TRANSFER_BIT;
         } break;
 
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: {
+            barrier.srcAccessMask   = VK_ACCESS_SHADER_READ_BIT;
+            src_stage               = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        } break;
+
         INVALID_DEFAULT_CASE;
     }
 
@@ -544,7 +623,7 @@ vk_recreate_swapchain(Vulkan *vk, u32 width, u32 height) {
 }
 
 function void
-vk_copy_buffer_to_image(Vulkan *vk, VkBuffer buffer, VkImage image, u32 width, u32 height) {
+vk_copy_buffer_to_image(Vulkan *vk, VkBuffer buffer, VkImage image, s32 x, s32 y, u32 width, u32 height) {
     VkCommandBuffer command_buffer = vk_begin_one_time_command(vk->device, vk->command_pool);
 
     VkBufferImageCopy region{};
@@ -555,7 +634,7 @@ vk_copy_buffer_to_image(Vulkan *vk, VkBuffer buffer, VkImage image, u32 width, u
     region.imageSubresource.mipLevel        = 0;
     region.imageSubresource.baseArrayLayer  = 0;
     region.imageSubresource.layerCount      = 1;
-    region.imageOffset                      = {0, 0, 0};
+    region.imageOffset                      = {x, y, 0};
     region.imageExtent.width                = width;
     region.imageExtent.height               = height;
     region.imageExtent.depth                = 1;
@@ -565,9 +644,128 @@ vk_copy_buffer_to_image(Vulkan *vk, VkBuffer buffer, VkImage image, u32 width, u
     vk_end_one_time_command(vk->device, command_buffer, vk->command_pool, vk->graphics_queue);
 }
 
+// @NOTE: Writes one element of the bindless texture array at binding 1.
+// Update-after-bind, so this is fine while the set is bound but not while a
+// submitted frame still reads the slot.
+function void
+vk_update_image_descriptor(Vulkan *vk, VkDescriptorSet descriptor_set, VkImageView view, u32 slot) {
+    ASSERT(slot < RENDERER_TEXTURE_SLOT_COUNT);
+
+    VkDescriptorImageInfo image_info{};
+    image_info.imageLayout  = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    image_info.imageView    = view;
+    image_info.sampler      = vk->DEBUG_texture_sampler;
+
+    VkWriteDescriptorSet descriptor_write{};
+
+    descriptor_write.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptor_write.dstSet           = descriptor_set;
+    descriptor_write.dstBinding       = 1;
+    descriptor_write.dstArrayElement  = slot;
+    descriptor_write.descriptorCount  = 1;
+    descriptor_write.descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptor_write.pBufferInfo      = 0;
+    descriptor_write.pImageInfo       = &image_info;
+    descriptor_write.pTexelBufferView = 0;
+
+    vkUpdateDescriptorSets(vk->device, 1, &descriptor_write, 0, 0);
+}
+
+function void
+vk_clear_image(Vulkan *vk, VkImage image) {
+    VkCommandBuffer command_buffer = vk_begin_one_time_command(vk->device, vk->command_pool);
+
+    VkClearColorValue clear_color{};
+    VkImageSubresourceRange range{};
+    range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel   = 0;
+    range.levelCount     = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount     = 1;
+    vkCmdClearColorImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_color, 1, &range);
+
+    vk_end_one_time_command(vk->device, command_buffer, vk->command_pool, vk->graphics_queue);
+}
+
+function void
+vk_create_atlas_page(Vulkan *vk, Texture_Upload upload) {
+    ASSERT(upload.page < RENDERER_ATLAS_PAGE_COUNT);
+    Vk_Image_Unit *unit = vk->atlas_pages + upload.page;
+    unit->slot = upload.slot;
+
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    vk_alloc_image(vk, &unit->image, &unit->memory, ATLAS_PAGE_DIM, ATLAS_PAGE_DIM,
+                   format, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+    vk_image_transition(vk, unit->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vk_clear_image(vk, unit->image);
+    vk_image_transition(vk, unit->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    unit->view = vk_create_image_view(vk, unit->image, format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    vk_update_image_descriptor(vk, vk->descriptor_set, unit->view, unit->slot);
+}
+
+// @NOTE: Assumes an RGBA8 texel, R in the low byte. Translucent draws blend
+// premultiplied, so textures are stored that way. This is done on the sRGB-encoded
+// values, which is exact for alpha 0 and 1 and close in between.
+function u32
+vk_premultiply_rgba8(u32 texel) {
+    u32 a = texel >> 24;
+    if (a == 0xFF) {
+        return texel;
+    }
+    u32 r = ((texel       & 0xFF)*a + 127) / 255;
+    u32 g = (((texel >> 8)  & 0xFF)*a + 127) / 255;
+    u32 b = (((texel >> 16) & 0xFF)*a + 127) / 255;
+    u32 result = (r | (g << 8) | (b << 16) | (a << 24));
+    return result;
+}
+
+// @NOTE: Copies the image with its edge texels extruded RENDERER_ATLAS_PADDING wide,
+// so (upload.x, upload.y) is the corner of the padding, not the image.
 function void
-vk_create_image(Vulkan *vk, Image data) {
+vk_upload_atlas_region(Vulkan *vk, Texture_Upload upload) {
+    ASSERT(upload.page < RENDERER_ATLAS_PAGE_COUNT);
+    Vk_Image_Unit *unit = vk->atlas_pages + upload.page;
+    Image data = upload.image;
+
+    s32 padding = RENDERER_ATLAS_PADDING;
+    u32 padded_width  = data.width  + 2*padding;
+    u32 padded_height = data.height + 2*padding;
+    VkDeviceSize size = padded_width * padded_height * 4;
+
+    VkBuffer staging_buffer{};
+    VkDeviceMemory staging_buffer_memory{};
+    vk_alloc_buffer(vk, &staging_buffer, &staging_buffer_memory, size,
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     VK_SHARING_MODE_EXCLUSIVE,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    SCOPE_EXIT(vkDestroyBuffer(vk->device, staging_buffer, 0));
+    SCOPE_EXIT(vkFreeMemory(vk->device, staging_buffer_memory, 0));
+
+    u32 *dst;
+    vkMapMemory(vk->device, staging_buffer_memory, 0, size, 0, (void **)&dst);
+    u32 *src = (u32 *)data.data;
+    for (u32 y = 0; y < padded_height; ++y) {
+        s32 src_y = clamp((s32)y - padding, 0, (s32)data.height - 1);
+        for (u32 x = 0; x < padded_width; ++x) {
+            s32 src_x = clamp((s32)x - padding, 0, (s32)data.width - 1);
+            dst[y*padded_width + x] = vk_premultiply_rgba8(src[src_y*data.width + src_x]);
+        }
+    }
+    vkUnmapMemory(vk->device, staging_buffer_memory);
+
+    vk_image_transition(vk, unit->image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vk_copy_buffer_to_image(vk, staging_buffer, unit->image, upload.x, upload.y, padded_width, padded_height);
+    vk_image_transition(vk, unit->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+function void
+vk_create_image(Vulkan *vk, Texture_Upload upload) {
+    Image data = upload.image;
     Vk_Image_Unit unit{};
+    unit.slot = upload.slot;
 
     VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
     u32 aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -583,44 +781,393 @@ vk_create_image(Vulkan *vk, Image data) {
     SCOPE_EXIT(vkDestroyBuffer(vk->device, staging_buffer, 0));
     SCOPE_EXIT(vkFreeMemory(vk->device, staging_buffer_memory, 0));
 
-    vk_copy_to_buffer(vk, data.data, 0, size, staging_buffer_memory);
+    u32 *dst;
+    vkMapMemory(vk->device, staging_buffer_memory, 0, size, 0, (void **)&dst);
+    u32 *src = (u32 *)data.data;
+    for (u32 i = 0; i < data.width*data.height; ++i) {
+        dst[i] = vk_premultiply_rgba8(src[i]);
+    }
+    vkUnmapMemory(vk->device, staging_buffer_memory);
 
     vk_alloc_image(vk, &unit.image, &unit.memory, data.width, data.height,
                    format, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
     vk_image_transition(vk, unit.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    vk_copy_buffer_to_image(vk, staging_buffer, unit.image, data.width, data.height);
+    vk_copy_buffer_to_image(vk, staging_buffer, unit.image, 0, 0, data.width, data.height);
     vk_image_transition(vk, unit.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
     unit.view = vk_create_image_view(vk, unit.image, format, aspect_mask);
 
+    vk_update_image_descriptor(vk, vk->descriptor_set, unit.view, unit.slot);
+
     vk->image_hash_table.insert(data.id, unit);
 }
 
+// @NOTE: The slot's descriptor is left dangling; the binding is partially bound
+// and nothing indexes the slot until it's handed out again.
 function void
-vk_update_image_descriptor(Vulkan *vk, VkDescriptorSet descriptor_set, u32 image_id, u32 binding) {
-    auto hash_result = vk->image_hash_table.get(image_id);
-    ASSERT(hash_result.found);
-    auto unit = hash_result.value;
+vk_destroy_image(Vulkan *vk, u32 image_id) {
+    Hash_Get_Result<Vk_Image_Unit> lookup = vk->image_hash_table.get(image_id);
+    ASSERT(lookup.found);
+    Vk_Image_Unit unit = lookup.value;
+    vk->image_hash_table.remove(image_id);
 
-    VkDescriptorImageInfo image_info{};
-    image_info.imageLayout  = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    image_info.imageView    = unit.view;
-    image_info.sampler      = vk->DEBUG_texture_sampler;
+    vkDestroyImageView(vk->device, unit.view, 0);
+    vkDestroyImage(vk->device, unit.image, 0);
+    vkFreeMemory(vk->device, unit.memory, 0);
 
-    VkWriteDescriptorSet descriptor_write{};
+    renderer_free_texture_slot(unit.slot);
+}
 
-    descriptor_write.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptor_write.dstSet           = descriptor_set;
-    descriptor_write.dstBinding       = binding;
-    descriptor_write.dstArrayElement  = 0;
-    descriptor_write.descriptorCount  = 1;
-    descriptor_write.descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptor_write.pBufferInfo      = 0;
-    descriptor_write.pImageInfo       = &image_info;
-    descriptor_write.pTexelBufferView = 0;
 
-    vkUpdateDescriptorSets(vk->device, 1, &descriptor_write, 0, 0);
+function VkPipeline
+vk_get_pipeline(Vulkan *vk, u32 pipeline, b32 translucent) {
+    VkPipeline result{};
+    switch (pipeline) {
+        case RENDERER_PIPELINE_SIMPLE: {
+            result = translucent ? vk->simple_pipeline : vk->simple_opaque_pipeline;
+        } break;
+
+        case RENDERER_PIPELINE_SIMPLE_COMPACT: {
+            result = translucent ? vk->simple_compact_pipeline : vk->simple_compact_opaque_pipeline;
+        } break;
+
+        case RENDERER_PIPELINE_SPRITE: {
+            result = translucent ? vk->sprite_pipeline : vk->sprite_opaque_pipeline;
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+    return result;
+}
+
+// @NOTE: z for a layer. Higher layers are nearer; depth is cleared to 1, so even
+// layer 0 passes, and ties pass too (LESS_OR_EQUAL) so a layer can draw over itself.
+function f32
+vk_layer_depth(u32 layer) {
+    u32 layer_count = 1 << SORT_KEY_LAYER_BITS;
+    f32 result = (f32)(layer_count - layer) / (f32)(layer_count + 1);
+    return result;
+}
+
+// @NOTE: Re-uploads static batches whose generation moved since we last saw them,
+// and frees the buffers of ones that were destroyed. Untouched ones cost a compare.
+function void
+vk_sync_static_batches(Vulkan *vk) {
+    for (u32 i = 0; i < renderer.static_batch_count; ++i) {
+        Static_Batch_Data *data = renderer.static_batches + i;
+        Vk_Static_Batch *batch = vk->static_batches + i;
+        if (batch->generation == data->generation) {
+            continue;
+        }
+
+        if (data->vertices.count) {
+            vk_upload_to_device_buffer(vk, &batch->buffer, &batch->memory, &batch->size,
+                                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                       data->vertices.data, data->vertices.count * sizeof(Vertex));
+        } else if (batch->size) {
+            vkDestroyBuffer(vk->device, batch->buffer, 0);
+            vkFreeMemory(vk->device, batch->memory, 0);
+            batch->buffer = VK_NULL_HANDLE;
+            batch->memory = VK_NULL_HANDLE;
+            batch->size   = 0;
+        }
+        batch->generation = data->generation;
+    }
+}
+
+// @NOTE: Scissor to the clip's rect, and a stencil test that passes where every
+// mask bit it needs is set. Clip 0 scissors to the whole target and tests no bits.
+function void
+vk_set_clip(Vulkan *vk, u32 clip_id) {
+    VkExtent2D extent = vk->swapchain_image_extent;
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    u32 stencil_bits = 0;
+    if (clip_id) {
+        Renderer_Clip *clip = renderer.clips + clip_id - 1;
+        s32 min_x = clamp(round_f32_to_s32(clip->rect.min.x), 0, (s32)extent.width);
+        s32 min_y = clamp(round_f32_to_s32(clip->rect.min.y), 0, (s32)extent.height);
+        s32 max_x = clamp(round_f32_to_s32(clip->rect.max.x), min_x, (s32)extent.width);
+        s32 max_y = clamp(round_f32_to_s32(clip->rect.max.y), min_y, (s32)extent.height);
+        scissor.offset = {min_x, min_y};
+        scissor.extent = {(u32)(max_x - min_x), (u32)(max_y - min_y)};
+        stencil_bits   = clip->stencil_bits;
+    }
+    vkCmdSetScissor(vk->command_buffer, 0, 1, &scissor);
+    vkCmdSetStencilCompareMask(vk->command_buffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil_bits);
+    vkCmdSetStencilReference(vk->command_buffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil_bits);
+}
+
+function void
+vk_cull_barrier(Vulkan *vk, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+    VkMemoryBarrier barrier{};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(vk->command_buffer, src_stage, dst_stage, 0, 1, &barrier, 0, 0, 0, 0);
+}
+
+function void
+vk_cull_dispatch(Vulkan *vk, Vk_Cull_Pass pass, u32 count, u32 group_count) {
+    Vk_Cull_Push_Constants push_constants{};
+    push_constants.pass  = pass;
+    push_constants.count = count;
+    vkCmdPushConstants(vk->command_buffer, vk->cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(push_constants), &push_constants);
+    vkCmdDispatch(vk->command_buffer, group_count, 1, 1);
+}
+
+// @NOTE: Records the sprite cull passes, outside the render pass. Every sprite
+// batch gets a Vk_Cull_Batch in batch order, which is also the order of the
+// draw commands vk_draw() reads back. Leaves cull_batches empty when there's
+// nothing to do, and sprites then draw straight from sprite_buffer.
+function void
+vk_cull_sprites(Vulkan *vk) {
+    vk->cull_tiles.clear();
+    vk->cull_batches.clear();
+    if (!renderer_gpu_culls_sprites()) {
+        return;
+    }
+
+    Rect2 view_rect = renderer.has_view ? renderer.cull_rect : rect2_min_max(v2{-F32_MAX, -F32_MAX}, v2{F32_MAX, F32_MAX});
+    u32 tested = 0;
+    for (u32 i = 0; i < renderer.batches.count; ++i) {
+        Render_Batch batch = renderer.batches.data[i];
+        if (batch.kind != RENDER_BATCH_SPRITES) {
+            continue;
+        }
+
+        Vk_Cull_Batch cull_batch{};
+        cull_batch.rect       = view_rect;
+        cull_batch.first      = batch.first;
+        cull_batch.first_tile = (u32)vk->cull_tiles.count;
+        cull_batch.tile_count = (batch.count + VK_CULL_TILE_SIZE - 1) / VK_CULL_TILE_SIZE;
+        if (batch.sort_key.clip) {
+            cull_batch.rect = intersect(cull_batch.rect, renderer.clips[batch.sort_key.clip - 1].world_bounds);
+        }
+        for (u32 t = 0; t < cull_batch.tile_count; ++t) {
+            Vk_Cull_Tile tile{};
+            tile.batch = (u32)vk->cull_batches.count;
+            tile.first = batch.first + t*VK_CULL_TILE_SIZE;
+            tile.count = MIN(VK_CULL_TILE_SIZE, batch.count - t*VK_CULL_TILE_SIZE);
+            vk->cull_tiles.push(tile);
+        }
+        vk->cull_batches.push(cull_batch);
+        tested += batch.count;
+    }
+
+    u32 tile_count  = (u32)vk->cull_tiles.count;
+    u32 batch_count = (u32)vk->cull_batches.count;
+    if (batch_count == 0) {
+        return;
+    }
+    ASSERT(tile_count <= vk->physical_device_properties.limits.maxComputeWorkGroupCount[0]);
+
+    vk_write_mapped_buffer(vk, &vk->cull_tile_buffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           vk->cull_tiles.data, tile_count*sizeof(Vk_Cull_Tile));
+    vk_write_mapped_buffer(vk, &vk->cull_batch_buffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           vk->cull_batches.data, batch_count*sizeof(Vk_Cull_Batch));
+    vk_fit_device_buffer(vk, &vk->culled_sprite_buffer, &vk->culled_sprite_buffer_memory, &vk->culled_sprite_buffer_size,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                         renderer.draw_lists[0].sprites.count*sizeof(Sprite_Instance));
+    vk_fit_device_buffer(vk, &vk->cull_tile_offset_buffer, &vk->cull_tile_offset_buffer_memory, &vk->cull_tile_offset_buffer_size,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, tile_count*sizeof(u32));
+    vk_fit_device_buffer(vk, &vk->indirect_buffer, &vk->indirect_buffer_memory, &vk->indirect_buffer_size,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                         batch_count*sizeof(VkDrawIndirectCommand));
+
+    // @NOTE: Any of these may have been reallocated above, so the set is rewritten
+    // every frame. The previous frame is done with it.
+    VkBuffer buffers[] = {
+        vk->sprite_buffer.buffer, vk->culled_sprite_buffer, vk->cull_tile_buffer.buffer, vk->cull_batch_buffer.buffer,
+        vk->cull_tile_offset_buffer, vk->indirect_buffer, vk->cull_stats_buffer,
+    };
+    VkDescriptorBufferInfo buffer_infos[arraycount(buffers)]{};
+    VkWriteDescriptorSet descriptor_writes[arraycount(buffers)]{};
+    for (u32 i = 0; i < arraycount(buffers); ++i) {
+        buffer_infos[i].buffer = buffers[i];
+        buffer_infos[i].offset = 0;
+        buffer_infos[i].range  = VK_WHOLE_SIZE;
+
+        descriptor_writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[i].dstSet          = vk->cull_descriptor_set;
+        descriptor_writes[i].dstBinding      = i;
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptor_writes[i].pBufferInfo     = buffer_infos + i;
+    }
+    vkUpdateDescriptorSets(vk->device, arraycount(descriptor_writes), descriptor_writes, 0, 0);
+
+    vkCmdFillBuffer(vk->command_buffer, vk->cull_stats_buffer, 0, sizeof(u32), 0);
+    vk_cull_barrier(vk, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    vkCmdBindPipeline(vk->command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk->cull_pipeline);
+    vkCmdBindDescriptorSets(vk->command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk->cull_pipeline_layout, 0, 1, &vk->cull_descriptor_set, 0, 0);
+
+    vk_cull_dispatch(vk, VK_CULL_COUNT, tile_count, tile_count);
+    vk_cull_barrier(vk, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    vk_cull_dispatch(vk, VK_CULL_SCAN, batch_count, (batch_count + VK_CULL_TILE_SIZE - 1) / VK_CULL_TILE_SIZE);
+    vk_cull_barrier(vk, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    vk_cull_dispatch(vk, VK_CULL_SCATTER, tile_count, tile_count);
+    vk_cull_barrier(vk, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+    vk->cull_tested  = tested;
+    vk->cull_pending = true;
+}
+
+// @NOTE: One command per batch, or per RENDERER_QUADS_PER_DRAW quads of one, with
+// the batch's layer as firstInstance for simple_vs. Runs break wherever pipeline,
+// clip or vertex buffer change, and around every sprite and static batch.
+function void
+vk_build_draw_runs(Vulkan *vk) {
+    // @NOTE: At most a run per batch, and a command per batch or quad chunk.
+    u32 command_bound = 0;
+    for (u32 i = 0; i < renderer.batches.count; ++i) {
+        command_bound += 1 + renderer.batches.data[i].count/(4*RENDERER_QUADS_PER_DRAW);
+    }
+    Memory_Arena *arena = &renderer.frame_arena;
+    vk->draw_runs = push_array(arena, Vk_Draw_Run, renderer.batches.count);
+    if (vk->multi_draw_indirect) {
+        vk_fit_mapped_buffer(vk, &vk->draw_command_buffer, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                             command_bound*sizeof(VkDrawIndirectCommand));
+        vk_fit_mapped_buffer(vk, &vk->indexed_draw_command_buffer, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                             command_bound*sizeof(VkDrawIndexedIndirectCommand));
+        vk->draw_commands         = (VkDrawIndirectCommand *)vk->draw_command_buffer.mapped;
+        vk->indexed_draw_commands = (VkDrawIndexedIndirectCommand *)vk->indexed_draw_command_buffer.mapped;
+    } else {
+        vk->draw_commands         = push_array(arena, VkDrawIndirectCommand, command_bound);
+        vk->indexed_draw_commands = push_array(arena, VkDrawIndexedIndirectCommand, command_bound);
+    }
+    vk->draw_run_count             = 0;
+    vk->draw_command_count         = 0;
+    vk->indexed_draw_command_count = 0;
+
+    u32 cull_index = 0;
+    for (u32 i = 0; i < renderer.batches.count; ++i) {
+        Render_Batch batch = renderer.batches.data[i];
+        Sort_Key sort_key = batch.sort_key;
+        b32 indexed = (batch.kind != RENDER_BATCH_TRIANGLES && batch.kind != RENDER_BATCH_SPRITES);
+
+        Vk_Draw_Run *run = vk->draw_run_count ? vk->draw_runs + vk->draw_run_count - 1 : 0;
+        if (!run || run->kind != batch.kind ||
+            batch.kind == RENDER_BATCH_SPRITES || batch.kind == RENDER_BATCH_STATIC ||
+            run->sort_key.pipeline != sort_key.pipeline || run->sort_key.translucent != sort_key.translucent ||
+            run->sort_key.clip != sort_key.clip) {
+            Vk_Draw_Run new_run{};
+            new_run.sort_key      = sort_key;
+            new_run.kind          = batch.kind;
+            new_run.indexed       = indexed;
+            new_run.first_command = indexed ? vk->indexed_draw_command_count : vk->draw_command_count;
+            if (batch.kind == RENDER_BATCH_STATIC) {
+                new_run.static_batch = batch.first;
+            }
+            if (batch.kind == RENDER_BATCH_SPRITES && vk->cull_batches.count) {
+                new_run.gpu_culled    = true;
+                new_run.first_command = cull_index++;
+                new_run.command_count = 1;
+            }
+            run = vk->draw_runs + vk->draw_run_count++;
+            *run = new_run;
+        }
+
+        switch (batch.kind) {
+            case RENDER_BATCH_TRIANGLES: {
+                VkDrawIndirectCommand command{};
+                command.vertexCount   = batch.count;
+                command.instanceCount = 1;
+                command.firstVertex   = batch.first;
+                command.firstInstance = sort_key.layer;
+                vk->draw_commands[vk->draw_command_count++] = command;
+                ++run->command_count;
+            } break;
+
+            case RENDER_BATCH_QUADS:
+            case RENDER_BATCH_COMPACT_QUADS:
+            case RENDER_BATCH_STATIC: {
+                // @NOTE: The index pattern always starts at quad 0; vertexOffset picks the
+                // quad. Static batches have a buffer of their own, starting at 0.
+                u32 first = (batch.kind == RENDER_BATCH_STATIC) ? 0 : batch.first;
+                u32 quad_count = batch.count / 4;
+                for (u32 quad = 0; quad < quad_count; quad += RENDERER_QUADS_PER_DRAW) {
+                    VkDrawIndexedIndirectCommand command{};
+                    command.indexCount    = 6*MIN(RENDERER_QUADS_PER_DRAW, quad_count - quad);
+                    command.instanceCount = 1;
+                    command.firstIndex    = 0;
+                    command.vertexOffset  = (s32)(first + 4*quad);
+                    command.firstInstance = sort_key.layer;
+                    vk->indexed_draw_commands[vk->indexed_draw_command_count++] = command;
+                    ++run->command_count;
+                }
+            } break;
+
+            case RENDER_BATCH_SPRITES: {
+                // @NOTE: sprite_vs expands 6 corners per instance from gl_VertexIndex.
+                if (!run->gpu_culled) {
+                    VkDrawIndirectCommand command{};
+                    command.vertexCount   = 6;
+                    command.instanceCount = batch.count;
+                    command.firstVertex   = 0;
+                    command.firstInstance = batch.first;
+                    vk->draw_commands[vk->draw_command_count++] = command;
+                    ++run->command_count;
+                }
+            } break;
+
+            INVALID_DEFAULT_CASE;
+        }
+    }
+
+}
+
+// @NOTE: Returns the number of draw calls recorded. A run is one call with
+// multiDrawIndirect, split only where it passes maxDrawIndirectCount.
+function u32
+vk_draw_run(Vulkan *vk, Vk_Draw_Run *run) {
+    if (run->gpu_culled) {
+        vkCmdDrawIndirect(vk->command_buffer, vk->indirect_buffer, run->first_command*sizeof(VkDrawIndirectCommand),
+                          1, sizeof(VkDrawIndirectCommand));
+        return 1;
+    }
+
+    u32 result = 0;
+    if (vk->multi_draw_indirect) {
+        u32 max_draw_count = vk->physical_device_properties.limits.maxDrawIndirectCount;
+        for (u32 first = 0; first < run->command_count; first += max_draw_count) {
+            u32 draw_count = MIN(max_draw_count, run->command_count - first);
+            u32 command = run->first_command + first;
+            if (run->indexed) {
+                vkCmdDrawIndexedIndirect(vk->command_buffer, vk->indexed_draw_command_buffer.buffer,
+                                         command*sizeof(VkDrawIndexedIndirectCommand),
+                                         draw_count, sizeof(VkDrawIndexedIndirectCommand));
+            } else {
+                vkCmdDrawIndirect(vk->command_buffer, vk->draw_command_buffer.buffer,
+                                  command*sizeof(VkDrawIndirectCommand),
+                                  draw_count, sizeof(VkDrawIndirectCommand));
+            }
+            ++result;
+        }
+    } else {
+        for (u32 i = 0; i < run->command_count; ++i) {
+            if (run->indexed) {
+                VkDrawIndexedIndirectCommand *c = vk->indexed_draw_commands + run->first_command + i;
+                vkCmdDrawIndexed(vk->command_buffer, c->indexCount, c->instanceCount, c->firstIndex, c->vertexOffset, c->firstInstance);
+            } else {
+                VkDrawIndirectCommand *c = vk->draw_commands + run->first_command + i;
+                vkCmdDraw(vk->command_buffer, c->vertexCount, c->instanceCount, c->firstVertex, c->firstInstance);
+            }
+            ++result;
+        }
+    }
+    return result;
 }
 
 function void
@@ -628,11 +1175,89 @@ vk_draw(Vulkan *vk) {
     vkWaitForFences(vk->device, 1, &vk->in_flight_fence, VK_TRUE, UINT64_MAX);
     vkResetFences(vk->device, 1, &vk->in_flight_fence);
 
+    // @NOTE: The previous frame is done, so its timestamps are ready.
+    if (vk->timestamp_pending) {
+        u64 timestamps[2];
+        if (vkGetQueryPoolResults(vk->device, vk->timestamp_pool, 0, 2, sizeof(timestamps), timestamps,
+                                  sizeof(u64), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            renderer.gpu_frame_ms = (f32)((f64)(timestamps[1] - timestamps[0])*vk->timestamp_period*1e-6);
+        }
+        vk->timestamp_pending = false;
+    }
+
+    if (vk->cull_pending) {
+        u32 visible = *vk->cull_stats_mapped;
+        renderer.gpu_cull_stats.tested = vk->cull_tested;
+        renderer.gpu_cull_stats.culled = vk->cull_tested - visible;
+        vk->cull_pending = false;
+    }
+
+
+    // @NOTE: Destroys before creates, since the table keeps one unit per id. A
+    // destroy whose id isn't in the table is for an image registered this frame;
+    // its create, the first one for that id in the queue, then only frees the slot.
+    // This covers an image registered and unregistered (and maybe registered again)
+    // in the same frame.
+    u32 image_id;
+    while (renderer.image_destroy_queue.pop(&image_id)) {
+        if (vk->image_hash_table.get(image_id).found) {
+            vk_destroy_image(vk, image_id);
+        } else {
+            vk->early_image_destroys.push(image_id);
+        }
+    }
+
+    Texture_Upload upload;
+    while (renderer.image_create_queue.pop(&upload)) {
+        switch (upload.kind) {
+            case TEXTURE_UPLOAD_IMAGE: {
+                b32 destroyed = false;
+                for (umm i = 0; i < vk->early_image_destroys.count; ++i) {
+                    if (vk->early_image_destroys.data[i] == upload.image.id) {
+                        vk->early_image_destroys.data[i] = vk->early_image_destroys.data[--vk->early_image_destroys.count];
+                        destroyed = true;
+                        break;
+                    }
+                }
+                if (destroyed) {
+                    renderer_free_texture_slot(upload.slot);
+                } else {
+                    vk_create_image(vk, upload);
+                }
+            } break;
 
-    while (!empty(&renderer.image_create_queue)) {
-        Image image = dequeue(&renderer.image_create_queue);
-        vk_create_image(vk, image);
+            case TEXTURE_UPLOAD_ATLAS_PAGE:     vk_create_atlas_page(vk, upload); break;
+            case TEXTURE_UPLOAD_ATLAS_REGION:   vk_upload_atlas_region(vk, upload); break;
+            INVALID_DEFAULT_CASE;
+        }
     }
+    ASSERT(vk->early_image_destroys.count == 0);
+
+    vk_sync_static_batches(vk);
+
+    /* Vertex Buffer */
+    Draw_List *list = renderer.draw_lists;
+    // @NOTE: Per-frame streams are written straight into mapped buffers; the GPU
+    // reads them over the bus once, which beats a staging copy and a queue wait each.
+    vk_write_mapped_buffer(vk, &vk->vertex_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                           list->vertices.data, list->vertices.count * sizeof(Vertex));
+
+    /* Quad Vertex Buffer */
+    vk_write_mapped_buffer(vk, &vk->quad_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                           list->quad_vertices.data, list->quad_vertices.count * sizeof(Vertex));
+
+    /* Compact Quad Vertex Buffer */
+    vk_write_mapped_buffer(vk, &vk->compact_quad_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                           list->compact_quad_vertices.data, list->compact_quad_vertices.count * sizeof(Vertex_Compact));
+
+    /* Sprite Instance Buffer */
+    vk_write_mapped_buffer(vk, &vk->sprite_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           list->sprites.data, list->sprites.count * sizeof(Sprite_Instance));
+
+
+    /* Clip Mask Vertex Buffer */
+    vk_write_mapped_buffer(vk, &vk->clip_mask_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                           renderer.clip_mask_vertices.data, renderer.clip_mask_vertices.count * sizeof(Vertex));
 
 
 
@@ -652,6 +1277,17 @@ vk_draw(Vulkan *vk) {
 
     vkBeginCommandBuffer(vk->command_buffer, &begin_info);
 
+    if (vk->timestamp_pool) {
+        vkCmdResetQueryPool(vk->command_buffer, vk->timestamp_pool, 0, 2);
+        vkCmdWriteTimestamp(vk->command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk->timestamp_pool, 0);
+    }
+
+    /* Sprite Culling */
+    vk_cull_sprites(vk);
+
+    /* Draw Commands */
+    vk_build_draw_runs(vk);
+
     VkClearValue clear_values[2]{}; 
     clear_values[0].color = {0.02f, 0.02f, 0.02f, 1.0f};
     clear_values[1].depthStencil = {1.0f, 0};
@@ -667,8 +1303,6 @@ vk_draw(Vulkan *vk) {
 
     vkCmdBeginRenderPass(vk->command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
-    vkCmdBindPipeline(vk->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->simple_pipeline);
-
     VkViewport viewport{};
     viewport.x          = 0.0f;
     viewport.y          = 0.0f;
@@ -683,57 +1317,101 @@ vk_draw(Vulkan *vk) {
     scissor.extent = vk->swapchain_image_extent;
     vkCmdSetScissor(vk->command_buffer, 0, 1, &scissor);
 
-    /* Vertex Buffer */
-    {
-        VkDeviceSize size = renderer.vertices.count * sizeof(Vertex);
-
-        VkBuffer staging_buffer{};
-        VkDeviceMemory staging_buffer_memory{};
+    /* Index Buffer */
+    vkCmdBindIndexBuffer(vk->command_buffer, vk->index_buffer, 0, VK_INDEX_TYPE_UINT16);
 
-        vk_alloc_buffer(vk, &staging_buffer, &staging_buffer_memory, size,
-                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_SHARING_MODE_EXCLUSIVE,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        SCOPE_EXIT(vkDestroyBuffer(vk->device, staging_buffer, 0));
-        SCOPE_EXIT(vkFreeMemory(vk->device, staging_buffer_memory, 0));
+    /* Descriptor */
+    // @NOTE: Bound once. Every texture lives in the bindless array and draws index it.
+    vkCmdBindDescriptorSets(vk->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->pipeline_layout, 0, 1, &vk->descriptor_set, 0, 0);
 
-        vk_copy_to_buffer(vk, renderer.vertices.data, 0, size, staging_buffer_memory);
-        vk_copy_buffer(vk, staging_buffer, vk->vertex_buffer, size);
+    /* Uniform */
+    Uniform_Buffer_Object ubo{};
+    ubo.ortho = vk_orthographic((f32)vk->swapchain_image_extent.width, (f32)vk->swapchain_image_extent.height);
+    if (renderer.has_camera) {
+        ubo.ortho = ubo.ortho * renderer.camera;
+    }
+    copy(&ubo, vk->uniform_buffer_mapped, sizeof(ubo));
+
+    /* Push Constants */
+    // @NOTE: Layouts match, so these stay set across pipeline binds; only sprite
+    // runs change depth.
+    Vk_Push_Constants push_constants{};
+    push_constants.layer_count = (f32)(1 << SORT_KEY_LAYER_BITS);
+    vkCmdPushConstants(vk->command_buffer, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT,
+                       0, sizeof(push_constants), &push_constants);
+
+    /* Clip Masks */
+    // @NOTE: Every mask goes into the stencil up front, before anything tests it.
+    if (renderer.clip_mask_count) {
+        vkCmdBindPipeline(vk->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->clip_mask_pipeline);
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(vk->command_buffer, 0, 1, &vk->clip_mask_buffer.buffer, offsets);
+        for (u32 i = 0; i < renderer.clip_count; ++i) {
+            Renderer_Clip *clip = renderer.clips + i;
+            if (clip->mask_bit) {
+                vkCmdSetStencilWriteMask(vk->command_buffer, VK_STENCIL_FACE_FRONT_AND_BACK, clip->mask_bit);
+                vkCmdDraw(vk->command_buffer, clip->mask_vertex_count, 1, clip->first_mask_vertex, 0);
+            }
+        }
     }
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(vk->command_buffer, 0, 1, &vk->vertex_buffer, offsets);
-
-
-    u32 drawn_triangle_count = 0;
-#if 1 /* Optimized Draw */
-    for (u32 i = 0; i < renderer.drawcall_vertex_count.count; ++i) {
-        u32 vertex_count_to_draw = renderer.drawcall_vertex_count.data[i];
-#else /* Unoptimized */
-    for (u32 i = 0; i < renderer.vertices.count; i += 3) {
-        u32 vertex_count_to_draw = 3;
-#endif
-
-        /* Update descriptor set before binding */
-        u32 image_id = renderer.sort_keys.data[drawn_triangle_count].image_id;
-        u32 sampler_binding = 1;
-        vk_update_image_descriptor(vk, vk->descriptor_set, image_id, sampler_binding);
 
-        /* Descriptor */
-        vkCmdBindDescriptorSets(vk->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->pipeline_layout, 0, 1, &vk->descriptor_set, 0, 0);
+    u32 bound_clip = (u32)-1;
+    u32 bound_pipeline = RENDERER_PIPELINE_COUNT;
+    b32 bound_translucent = false;
+    u32 bound_kind = (u32)-1;
+    u32 draw_call_count = 0;
+    for (u32 i = 0; i < vk->draw_run_count; ++i) {
+        Vk_Draw_Run *run = vk->draw_runs + i;
+        Sort_Key sort_key = run->sort_key;
+
+        /* Pipeline */
+        if (sort_key.pipeline != bound_pipeline || sort_key.translucent != bound_translucent) {
+            vkCmdBindPipeline(vk->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              vk_get_pipeline(vk, sort_key.pipeline, sort_key.translucent));
+            bound_pipeline = sort_key.pipeline;
+            bound_translucent = sort_key.translucent;
+        }
 
-        /* Uniform */
-        Uniform_Buffer_Object ubo{};
-        ubo.ortho = vk_orthographic((f32)vk->swapchain_image_extent.width, (f32)vk->swapchain_image_extent.height);
+        /* Clip */
+        if (sort_key.clip != bound_clip) {
+            vk_set_clip(vk, sort_key.clip);
+            bound_clip = sort_key.clip;
+        }
 
-        copy(&ubo, vk->uniform_buffer_mapped, sizeof(ubo));
+        /* Depth */
+        if (run->kind == RENDER_BATCH_SPRITES) {
+            push_constants.depth = vk_layer_depth(sort_key.layer);
+            vkCmdPushConstants(vk->command_buffer, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT,
+                               0, sizeof(push_constants), &push_constants);
+        }
 
-        vkCmdDraw(vk->command_buffer, vertex_count_to_draw, 1, drawn_triangle_count*3, 0);
+        /* Vertex Buffer */
+        if (run->kind == RENDER_BATCH_STATIC) {
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(vk->command_buffer, 0, 1, &vk->static_batches[run->static_batch - 1].buffer, offsets);
+            bound_kind = (u32)-1;
+        } else if ((u32)run->kind != bound_kind) {
+            VkBuffer vertex_buffer = vk->vertex_buffer.buffer;
+            if (run->kind == RENDER_BATCH_QUADS)         vertex_buffer = vk->quad_buffer.buffer;
+            if (run->kind == RENDER_BATCH_COMPACT_QUADS) vertex_buffer = vk->compact_quad_buffer.buffer;
+            if (run->kind == RENDER_BATCH_SPRITES) {
+                vertex_buffer = vk->cull_batches.count ? vk->culled_sprite_buffer : vk->sprite_buffer.buffer;
+            }
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(vk->command_buffer, 0, 1, &vertex_buffer, offsets);
+            bound_kind = run->kind;
+        }
 
-        drawn_triangle_count += (vertex_count_to_draw/3);
+        draw_call_count += vk_draw_run(vk, run);
     }
+    renderer.draw_call_count = draw_call_count;
 
     /* End */
     vkCmdEndRenderPass(vk->command_buffer);
+    if (vk->timestamp_pool) {
+        vkCmdWriteTimestamp(vk->command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk->timestamp_pool, 1);
+        vk->timestamp_pending = true;
+    }
     ASSERT(vkEndCommandBuffer(vk->command_buffer) == VK_SUCCESS);
 
 
@@ -774,13 +1452,27 @@ vk_init(Vulkan *vk) {
     vk_create_device(vk);
     vk_get_queue_handles_from_device(vk);
 
+    // @NOTE: Commands carry the layer in firstInstance, so indirect draws need both.
+    VkPhysicalDeviceFeatures *features = &vk->physical_device_features.features;
+    vk->multi_draw_indirect = (features->multiDrawIndirect && features->drawIndirectFirstInstance);
+
+    // @NOTE: GPU frame time for replays; left off where the device can't timestamp.
+    if (vk->physical_device_properties.limits.timestampComputeAndGraphics) {
+        VkQueryPoolCreateInfo query_pool_create_info{};
+        query_pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_create_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = 2;
+        ASSERT(vkCreateQueryPool(vk->device, &query_pool_create_info, 0, &vk->timestamp_pool) == VK_SUCCESS);
+        vk->timestamp_period = vk->physical_device_properties.limits.timestampPeriod;
+    }
+
     VkSurfaceCapabilitiesKHR surface_capabilities{};
     ASSERT(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vk->physical_device, vk->surface, &surface_capabilities) == VK_SUCCESS);
 
     u32 present_mode_count = 0;
     vkGetPhysicalDeviceSurfacePresentModesKHR(vk->physical_device, vk->surface, &present_mode_count, 0);
-    VkPresentModeKHR *present_modes = (VkPresentModeKHR *)os.alloc(sizeof(VkPresentModeKHR) * present_mode_count);
-    SCOPE_EXIT(os.free(present_modes));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkPresentModeKHR *present_modes = push_array(&renderer.frame_arena, VkPresentModeKHR, present_mode_count);
     ASSERT(vkGetPhysicalDeviceSurfacePresentModesKHR(vk->physical_device, vk->surface, &present_mode_count, present_modes) == VK_SUCCESS);
 
     // @NOTE: FIFO is always available.
@@ -817,8 +1509,7 @@ vk_init(Vulkan *vk) {
     VkSurfaceFormatKHR *surface_formats{};
     u32 surface_format_count;
     vkGetPhysicalDeviceSurfaceFormatsKHR(vk->physical_device, vk->surface, &surface_format_count, 0);
-    surface_formats = (VkSurfaceFormatKHR *)os.alloc(sizeof(VkSurfaceFormatKHR) * surface_format_count);
-    SCOPE_EXIT(os.free(surface_formats));
+    surface_formats = push_array(&renderer.frame_arena, VkSurfaceFormatKHR, surface_format_count);
     ASSERT(vkGetPhysicalDeviceSurfaceFormatsKHR(vk->physical_device, vk->surface, &surface_format_count, surface_formats) == VK_SUCCESS);
     ASSERT(surface_format_count > 0);
 
@@ -924,6 +1615,7 @@ vk_init(Vulkan *vk) {
     //
     Buffer vs_spv = read_entire_file("../data/shaders/simple_vs.spv");
     Buffer fs_spv = read_entire_file("../data/shaders/simple_fs.spv");
+    ASSERT(vs_spv.size && fs_spv.size);
     VkShaderModule vs_module = vk_create_shader_module(vk->device, vs_spv.data, vs_spv.size);
     VkShaderModule fs_module = vk_create_shader_module(vk->device, fs_spv.data, fs_spv.size);
 
@@ -947,7 +1639,7 @@ vk_init(Vulkan *vk) {
     v_binding.stride    = sizeof(Vertex);
     v_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-    VkVertexInputAttributeDescription v_attributes[3];
+    VkVertexInputAttributeDescription v_attributes[4];
     v_attributes[0].binding  = 0;
     v_attributes[0].location = 0;
     v_attributes[0].format   = VK_FORMAT_R32G32_SFLOAT;
@@ -960,6 +1652,10 @@ vk_init(Vulkan *vk) {
     v_attributes[2].location = 2;
     v_attributes[2].format   = VK_FORMAT_R32G32_SFLOAT;
     v_attributes[2].offset   = offset_of(Vertex, uv);
+    v_attributes[3].binding  = 0;
+    v_attributes[3].location = 3;
+    v_attributes[3].format   = VK_FORMAT_R32_UINT;
+    v_attributes[3].offset   = offset_of(Vertex, texture);
 
 
 
@@ -975,9 +1671,12 @@ vk_init(Vulkan *vk) {
     input_assembly_state.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     input_assembly_state.primitiveRestartEnable = VK_FALSE;
 
+    // @NOTE: Scissor and the stencil test come from the batch's clip; see vk_set_clip().
     VkDynamicState dynamic_states[] = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
+        VK_DYNAMIC_STATE_STENCIL_REFERENCE,
     };
 
     VkPipelineDynamicStateCreateInfo dynamic_state{};
@@ -1015,11 +1714,11 @@ vk_init(Vulkan *vk) {
     VkPipelineColorBlendAttachmentState color_blend_attachment{};
     color_blend_attachment.colorWriteMask       = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     color_blend_attachment.blendEnable          = VK_TRUE;
-    color_blend_attachment.srcColorBlendFactor  = VK_BLEND_FACTOR_SRC_ALPHA;
+    color_blend_attachment.srcColorBlendFactor  = VK_BLEND_FACTOR_ONE;
     color_blend_attachment.dstColorBlendFactor  = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
     color_blend_attachment.colorBlendOp         = VK_BLEND_OP_ADD;
     color_blend_attachment.srcAlphaBlendFactor  = VK_BLEND_FACTOR_ONE;
-    color_blend_attachment.dstAlphaBlendFactor  = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.dstAlphaBlendFactor  = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
     color_blend_attachment.alphaBlendOp         = VK_BLEND_OP_ADD;
 
     VkPipelineColorBlendStateCreateInfo colorblend_state{};
@@ -1036,12 +1735,30 @@ vk_init(Vulkan *vk) {
     VkPipelineDepthStencilStateCreateInfo depth_stencil_state{};
     depth_stencil_state.sType                   = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     depth_stencil_state.depthTestEnable         = VK_TRUE;
-    depth_stencil_state.depthWriteEnable        = VK_TRUE;
-    depth_stencil_state.depthCompareOp          = VK_COMPARE_OP_LESS;
+    depth_stencil_state.depthWriteEnable        = VK_FALSE;
+    depth_stencil_state.depthCompareOp          = VK_COMPARE_OP_LESS_OR_EQUAL;
     depth_stencil_state.depthBoundsTestEnable   = VK_FALSE;
     depth_stencil_state.minDepthBounds          = 0.0f;
     depth_stencil_state.maxDepthBounds          = 1.0f;
-    depth_stencil_state.stencilTestEnable       = VK_FALSE;
+    depth_stencil_state.stencilTestEnable       = VK_TRUE;
+    depth_stencil_state.front.failOp            = VK_STENCIL_OP_KEEP;
+    depth_stencil_state.front.passOp            = VK_STENCIL_OP_KEEP;
+    depth_stencil_state.front.depthFailOp       = VK_STENCIL_OP_KEEP;
+    depth_stencil_state.front.compareOp         = VK_COMPARE_OP_EQUAL;
+    depth_stencil_state.front.writeMask         = 0;
+    depth_stencil_state.back                    = depth_stencil_state.front;
+
+    // @NOTE: The state above is the translucent pass: premultiplied blending, depth
+    // tested against opaque draws but not written. The opaque pass doesn't blend
+    // and writes depth.
+    VkPipelineColorBlendAttachmentState opaque_color_blend_attachment = color_blend_attachment;
+    opaque_color_blend_attachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo opaque_colorblend_state = colorblend_state;
+    opaque_colorblend_state.pAttachments = &opaque_color_blend_attachment;
+
+    VkPipelineDepthStencilStateCreateInfo opaque_depth_stencil_state = depth_stencil_state;
+    opaque_depth_stencil_state.depthWriteEnable = VK_TRUE;
 
     VkDescriptorSetLayoutBinding ubo_layout_binding{};
     ubo_layout_binding.binding              = 0;
@@ -1053,7 +1770,7 @@ vk_init(Vulkan *vk) {
     VkDescriptorSetLayoutBinding sampler_layout_binding{};
     sampler_layout_binding.binding              = 1;
     sampler_layout_binding.descriptorType       = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    sampler_layout_binding.descriptorCount      = 1;
+    sampler_layout_binding.descriptorCount      = RENDERER_TEXTURE_SLOT_COUNT;
     sampler_layout_binding.stageFlags           = VK_SHADER_STAGE_FRAGMENT_BIT;
     sampler_layout_binding.pImmutableSamplers   = 0;
 
@@ -1062,7 +1779,10 @@ vk_init(Vulkan *vk) {
 
     VkDescriptorSetLayout descriptor_set_layout{};
 
-    VkDescriptorBindingFlagsEXT flags[] = {0, 0};
+    VkDescriptorBindingFlagsEXT flags[] = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
+    };
 
     VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags{};
     binding_flags.sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
@@ -1082,8 +1802,13 @@ vk_init(Vulkan *vk) {
     pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipeline_layout_info.setLayoutCount         = 1;
     pipeline_layout_info.pSetLayouts            = &descriptor_set_layout;
-    pipeline_layout_info.pushConstantRangeCount = 0;
-    pipeline_layout_info.pPushConstantRanges    = 0;
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_constant_range.offset     = 0;
+    push_constant_range.size       = sizeof(Vk_Push_Constants);
+
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges    = &push_constant_range;
 
     
     vkCreatePipelineLayout(vk->device, &pipeline_layout_info, 0, &vk->pipeline_layout);
@@ -1109,7 +1834,7 @@ vk_init(Vulkan *vk) {
     depth_attachment.samples        = VK_SAMPLE_COUNT_1_BIT;
     depth_attachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
     depth_attachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-    depth_attachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depth_attachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
     depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth_attachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
     depth_attachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -1172,6 +1897,161 @@ vk_init(Vulkan *vk) {
     VkPipelineCache cache = VK_NULL_HANDLE;
     ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &pipeline_create_info, 0, &vk->simple_pipeline) == VK_SUCCESS);
 
+    VkGraphicsPipelineCreateInfo opaque_pipeline_create_info = pipeline_create_info;
+    opaque_pipeline_create_info.pDepthStencilState = &opaque_depth_stencil_state;
+    opaque_pipeline_create_info.pColorBlendState   = &opaque_colorblend_state;
+    ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &opaque_pipeline_create_info, 0, &vk->simple_opaque_pipeline) == VK_SUCCESS);
+
+
+    //
+    // Clip Mask Pipeline
+    //
+    // @NOTE: Same shaders as simple_pipeline. Sets the clip's stencil bit (the
+    // write mask) wherever its triangles land, no color and no depth. Nothing is
+    // culled, so mask winding doesn't matter.
+    {
+        VkDynamicState clip_mask_dynamic_states[] = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR,
+            VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
+        };
+
+        VkPipelineDynamicStateCreateInfo clip_mask_dynamic_state = dynamic_state;
+        clip_mask_dynamic_state.dynamicStateCount = arraycount(clip_mask_dynamic_states);
+        clip_mask_dynamic_state.pDynamicStates    = clip_mask_dynamic_states;
+
+        VkPipelineRasterizationStateCreateInfo clip_mask_rasterization_state = rasterization_state;
+        clip_mask_rasterization_state.cullMode = VK_CULL_MODE_NONE;
+
+        VkPipelineColorBlendAttachmentState clip_mask_color_blend_attachment = opaque_color_blend_attachment;
+        clip_mask_color_blend_attachment.colorWriteMask = 0;
+
+        VkPipelineColorBlendStateCreateInfo clip_mask_colorblend_state = colorblend_state;
+        clip_mask_colorblend_state.pAttachments = &clip_mask_color_blend_attachment;
+
+        VkPipelineDepthStencilStateCreateInfo clip_mask_depth_stencil_state = depth_stencil_state;
+        clip_mask_depth_stencil_state.depthTestEnable   = VK_FALSE;
+        clip_mask_depth_stencil_state.front.passOp      = VK_STENCIL_OP_REPLACE;
+        clip_mask_depth_stencil_state.front.compareOp   = VK_COMPARE_OP_ALWAYS;
+        clip_mask_depth_stencil_state.front.compareMask = 0xFF;
+        clip_mask_depth_stencil_state.front.reference   = 0xFF;
+        clip_mask_depth_stencil_state.back              = clip_mask_depth_stencil_state.front;
+
+        VkGraphicsPipelineCreateInfo clip_mask_pipeline_create_info = pipeline_create_info;
+        clip_mask_pipeline_create_info.pRasterizationState = &clip_mask_rasterization_state;
+        clip_mask_pipeline_create_info.pDepthStencilState  = &clip_mask_depth_stencil_state;
+        clip_mask_pipeline_create_info.pColorBlendState    = &clip_mask_colorblend_state;
+        clip_mask_pipeline_create_info.pDynamicState       = &clip_mask_dynamic_state;
+        ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &clip_mask_pipeline_create_info, 0, &vk->clip_mask_pipeline) == VK_SUCCESS);
+    }
+
+
+    //
+    // Compact Pipeline
+    //
+    // @NOTE: Same shaders as simple_pipeline. The UNORM formats hand simple_vs the
+    // same normalized vec4 color and vec2 uv it gets from Vertex.
+    {
+        VkVertexInputBindingDescription compact_binding{};
+        compact_binding.binding   = 0;
+        compact_binding.stride    = sizeof(Vertex_Compact);
+        compact_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        VkVertexInputAttributeDescription compact_attributes[4];
+        compact_attributes[0].binding  = 0;
+        compact_attributes[0].location = 0;
+        compact_attributes[0].format   = VK_FORMAT_R32G32_SFLOAT;
+        compact_attributes[0].offset   = offset_of(Vertex_Compact, position);
+        compact_attributes[1].binding  = 0;
+        compact_attributes[1].location = 1;
+        compact_attributes[1].format   = VK_FORMAT_R8G8B8A8_UNORM;
+        compact_attributes[1].offset   = offset_of(Vertex_Compact, color);
+        compact_attributes[2].binding  = 0;
+        compact_attributes[2].location = 2;
+        compact_attributes[2].format   = VK_FORMAT_R16G16_UNORM;
+        compact_attributes[2].offset   = offset_of(Vertex_Compact, uv);
+        compact_attributes[3].binding  = 0;
+        compact_attributes[3].location = 3;
+        compact_attributes[3].format   = VK_FORMAT_R32_UINT;
+        compact_attributes[3].offset   = offset_of(Vertex_Compact, texture);
+
+        VkPipelineVertexInputStateCreateInfo compact_vertex_input_state = vertex_input_state;
+        compact_vertex_input_state.pVertexBindingDescriptions      = &compact_binding;
+        compact_vertex_input_state.vertexAttributeDescriptionCount = arraycount(compact_attributes);
+        compact_vertex_input_state.pVertexAttributeDescriptions    = compact_attributes;
+
+        VkGraphicsPipelineCreateInfo compact_pipeline_create_info = pipeline_create_info;
+        compact_pipeline_create_info.pVertexInputState = &compact_vertex_input_state;
+
+        ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &compact_pipeline_create_info, 0, &vk->simple_compact_pipeline) == VK_SUCCESS);
+
+        compact_pipeline_create_info.pDepthStencilState = &opaque_depth_stencil_state;
+        compact_pipeline_create_info.pColorBlendState   = &opaque_colorblend_state;
+        ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &compact_pipeline_create_info, 0, &vk->simple_compact_opaque_pipeline) == VK_SUCCESS);
+    }
+
+
+    //
+    // Sprite Pipeline
+    //
+    // @NOTE: Same state as simple_pipeline; one Sprite_Instance per instance and
+    // the corners come from gl_VertexIndex, so there's no per-vertex input.
+    {
+        Buffer sprite_vs_spv = read_entire_file("../data/shaders/sprite_vs.spv");
+        ASSERT(sprite_vs_spv.size);
+        VkShaderModule sprite_vs_module = vk_create_shader_module(vk->device, sprite_vs_spv.data, sprite_vs_spv.size);
+
+        VkPipelineShaderStageCreateInfo sprite_shader_stages[] = {vs_stage_info, fs_stage_info};
+        sprite_shader_stages[0].module = sprite_vs_module;
+
+        VkVertexInputBindingDescription sprite_binding{};
+        sprite_binding.binding   = 0;
+        sprite_binding.stride    = sizeof(Sprite_Instance);
+        sprite_binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        VkVertexInputAttributeDescription sprite_attributes[6];
+        sprite_attributes[0].binding  = 0;
+        sprite_attributes[0].location = 0;
+        sprite_attributes[0].format   = VK_FORMAT_R32G32_SFLOAT;
+        sprite_attributes[0].offset   = offset_of(Sprite_Instance, center);
+        sprite_attributes[1].binding  = 0;
+        sprite_attributes[1].location = 1;
+        sprite_attributes[1].format   = VK_FORMAT_R32G32_SFLOAT;
+        sprite_attributes[1].offset   = offset_of(Sprite_Instance, half_dim);
+        sprite_attributes[2].binding  = 0;
+        sprite_attributes[2].location = 2;
+        sprite_attributes[2].format   = VK_FORMAT_R16G16B16A16_UNORM;
+        sprite_attributes[2].offset   = offset_of(Sprite_Instance, uv_min);
+        sprite_attributes[3].binding  = 0;
+        sprite_attributes[3].location = 3;
+        sprite_attributes[3].format   = VK_FORMAT_R8G8B8A8_UNORM;
+        sprite_attributes[3].offset   = offset_of(Sprite_Instance, color);
+        sprite_attributes[4].binding  = 0;
+        sprite_attributes[4].location = 4;
+        sprite_attributes[4].format   = VK_FORMAT_R16_UINT;
+        sprite_attributes[4].offset   = offset_of(Sprite_Instance, texture);
+        sprite_attributes[5].binding  = 0;
+        sprite_attributes[5].location = 5;
+        sprite_attributes[5].format   = VK_FORMAT_R16_UNORM;
+        sprite_attributes[5].offset   = offset_of(Sprite_Instance, rotation);
+
+        VkPipelineVertexInputStateCreateInfo sprite_vertex_input_state = vertex_input_state;
+        sprite_vertex_input_state.pVertexBindingDescriptions      = &sprite_binding;
+        sprite_vertex_input_state.vertexAttributeDescriptionCount = arraycount(sprite_attributes);
+        sprite_vertex_input_state.pVertexAttributeDescriptions    = sprite_attributes;
+
+        VkGraphicsPipelineCreateInfo sprite_pipeline_create_info = pipeline_create_info;
+        sprite_pipeline_create_info.stageCount        = arraycount(sprite_shader_stages);
+        sprite_pipeline_create_info.pStages           = sprite_shader_stages;
+        sprite_pipeline_create_info.pVertexInputState = &sprite_vertex_input_state;
+
+        ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &sprite_pipeline_create_info, 0, &vk->sprite_pipeline) == VK_SUCCESS);
+
+        sprite_pipeline_create_info.pDepthStencilState = &opaque_depth_stencil_state;
+        sprite_pipeline_create_info.pColorBlendState   = &opaque_colorblend_state;
+        ASSERT(vkCreateGraphicsPipelines(vk->device, cache, 1, &sprite_pipeline_create_info, 0, &vk->sprite_opaque_pipeline) == VK_SUCCESS);
+    }
+
 
     vk->swapchain_framebuffers = (VkFramebuffer *)os.alloc(sizeof(VkFramebuffer) * vk->swapchain_image_count);
     for (u32 i = 0; i < vk->swapchain_image_count; i++) {
@@ -1238,7 +2118,7 @@ vk_init(Vulkan *vk) {
                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
     vk_image_transition(vk, vk->DEBUG_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    vk_copy_buffer_to_image(vk, staging_buffer, vk->DEBUG_image, width, height);
+    vk_copy_buffer_to_image(vk, staging_buffer, vk->DEBUG_image, 0, 0, width, height);
     vk_image_transition(vk, vk->DEBUG_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
     vk->DEBUG_texture_image_view = vk_create_image_view(vk, vk->DEBUG_image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
@@ -1270,22 +2150,52 @@ vk_init(Vulkan *vk) {
     // Vertex Buffer
     //
     {
-        VkDeviceSize temporary_size = sizeof(Vertex) * 4096;
-        vk_alloc_buffer(vk, &vk->vertex_buffer, &vk->vertex_buffer_memory, temporary_size,
-                         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                         VK_SHARING_MODE_EXCLUSIVE,
-                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        vk_fit_mapped_buffer(vk, &vk->vertex_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(Vertex) * 4096);
+    }
+
+    //
+    // Quad Vertex Buffer
+    //
+    {
+        vk_fit_mapped_buffer(vk, &vk->quad_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(Vertex) * 4096);
+    }
+
+    //
+    // Compact Quad Vertex Buffer
+    //
+    {
+        vk_fit_mapped_buffer(vk, &vk->compact_quad_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(Vertex_Compact) * 4096);
+    }
+
+    //
+    // Sprite Instance Buffer
+    //
+    {
+        vk_fit_mapped_buffer(vk, &vk->sprite_buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(Sprite_Instance) * 4096);
     }
 
     //
     // Index Buffer
     //
+    // @NOTE: Static quad pattern, filled once. Every quad batch draws from index 0.
     {
-        VkDeviceSize temporary_size = sizeof(u32) * 500;
-        vk_alloc_buffer(vk, &vk->index_buffer, &vk->index_buffer_memory, temporary_size,
-                         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                         VK_SHARING_MODE_EXCLUSIVE,
-                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        u32 index_count = 6*RENDERER_QUADS_PER_DRAW;
+        VkDeviceSize size = sizeof(u16) * index_count;
+        TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+        u16 *indices = push_array(&renderer.frame_arena, u16, index_count);
+        for (u32 quad = 0; quad < RENDERER_QUADS_PER_DRAW; ++quad) {
+            u16 base = (u16)(4*quad);
+            indices[6*quad + 0] = base + 0;
+            indices[6*quad + 1] = base + 1;
+            indices[6*quad + 2] = base + 2;
+            indices[6*quad + 3] = base + 2;
+            indices[6*quad + 4] = base + 1;
+            indices[6*quad + 5] = base + 3;
+        }
+
+        vk->index_buffer_size = 0;
+        vk_upload_to_device_buffer(vk, &vk->index_buffer, &vk->index_buffer_memory, &vk->index_buffer_size,
+                                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices, size);
     }
 
     //
@@ -1305,7 +2215,7 @@ vk_init(Vulkan *vk) {
     pool_sizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     pool_sizes[0].descriptorCount = 1; // @TODO: MAX_FRAME_IN_FLIGHT
     pool_sizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_sizes[1].descriptorCount = 1; // @TODO: MAX_FRAME_IN_FLIGHT
+    pool_sizes[1].descriptorCount = RENDERER_TEXTURE_SLOT_COUNT; // @TODO: MAX_FRAME_IN_FLIGHT
 
     VkDescriptorPoolCreateInfo pool_info{};
     pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -1344,4 +2254,84 @@ vk_init(Vulkan *vk) {
     descriptor_writes[0].pImageInfo       = 0;
     descriptor_writes[0].pTexelBufferView = 0;
     vkUpdateDescriptorSets(vk->device, arraycount(descriptor_writes), descriptor_writes, 0, 0);
+
+    // @NOTE: Slot 0 is the default texture for untextured draws.
+    vk_update_image_descriptor(vk, vk->descriptor_set, vk->DEBUG_texture_image_view, 0);
+
+
+    //
+    // Sprite Cull Pipeline
+    //
+    // @NOTE: Only with firstInstance in indirect draws, since each batch's survivors
+    // start at its first instance.
+    Buffer cull_spv = read_entire_file("../data/shaders/sprite_cull.spv");
+    ASSERT(cull_spv.size);
+    if (vk->physical_device_features.features.drawIndirectFirstInstance) {
+        VkDescriptorSetLayoutBinding cull_bindings[7]{};
+        for (u32 i = 0; i < arraycount(cull_bindings); ++i) {
+            cull_bindings[i].binding         = i;
+            cull_bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            cull_bindings[i].descriptorCount = 1;
+            cull_bindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo cull_set_layout_create_info{};
+        cull_set_layout_create_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        cull_set_layout_create_info.bindingCount = arraycount(cull_bindings);
+        cull_set_layout_create_info.pBindings    = cull_bindings;
+        VkDescriptorSetLayout cull_set_layout{};
+        ASSERT(vkCreateDescriptorSetLayout(vk->device, &cull_set_layout_create_info, 0, &cull_set_layout) == VK_SUCCESS);
+
+        VkDescriptorPoolSize cull_pool_size{};
+        cull_pool_size.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        cull_pool_size.descriptorCount = arraycount(cull_bindings);
+
+        VkDescriptorPoolCreateInfo cull_pool_info{};
+        cull_pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        cull_pool_info.poolSizeCount = 1;
+        cull_pool_info.pPoolSizes    = &cull_pool_size;
+        cull_pool_info.maxSets       = 1;
+        VkDescriptorPool cull_pool{};
+        ASSERT(vkCreateDescriptorPool(vk->device, &cull_pool_info, 0, &cull_pool) == VK_SUCCESS);
+
+        VkDescriptorSetAllocateInfo cull_set_alloc_info{};
+        cull_set_alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        cull_set_alloc_info.descriptorPool     = cull_pool;
+        cull_set_alloc_info.descriptorSetCount = 1;
+        cull_set_alloc_info.pSetLayouts        = &cull_set_layout;
+        ASSERT(vkAllocateDescriptorSets(vk->device, &cull_set_alloc_info, &vk->cull_descriptor_set) == VK_SUCCESS);
+
+        VkPushConstantRange cull_push_constant_range{};
+        cull_push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        cull_push_constant_range.offset     = 0;
+        cull_push_constant_range.size       = sizeof(Vk_Cull_Push_Constants);
+
+        VkPipelineLayoutCreateInfo cull_pipeline_layout_info{};
+        cull_pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        cull_pipeline_layout_info.setLayoutCount         = 1;
+        cull_pipeline_layout_info.pSetLayouts            = &cull_set_layout;
+        cull_pipeline_layout_info.pushConstantRangeCount = 1;
+        cull_pipeline_layout_info.pPushConstantRanges    = &cull_push_constant_range;
+        ASSERT(vkCreatePipelineLayout(vk->device, &cull_pipeline_layout_info, 0, &vk->cull_pipeline_layout) == VK_SUCCESS);
+
+        VkShaderModule cull_module = vk_create_shader_module(vk->device, cull_spv.data, cull_spv.size);
+
+        VkComputePipelineCreateInfo cull_pipeline_create_info{};
+        cull_pipeline_create_info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        cull_pipeline_create_info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        cull_pipeline_create_info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+        cull_pipeline_create_info.stage.module = cull_module;
+        cull_pipeline_create_info.stage.pName  = "main";
+        cull_pipeline_create_info.layout       = vk->cull_pipeline_layout;
+        ASSERT(vkCreateComputePipelines(vk->device, VK_NULL_HANDLE, 1, &cull_pipeline_create_info, 0, &vk->cull_pipeline) == VK_SUCCESS);
+        vkDestroyShaderModule(vk->device, cull_module, 0);
+
+        vk_alloc_buffer(vk, &vk->cull_stats_buffer, &vk->cull_stats_buffer_memory, sizeof(u32),
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                        VK_SHARING_MODE_EXCLUSIVE,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        vkMapMemory(vk->device, vk->cull_stats_buffer_memory, 0, sizeof(u32), 0, (void **)&vk->cull_stats_mapped);
+
+        renderer.gpu_cull_supported = true;
+    }
 }
@@ -17,6 +17,78 @@ struct Vk_Image_Unit {
     VkImage image;
     VkDeviceMemory memory;
     VkImageView view;
+    u32 slot;
+};
+
+// @NOTE: Matches push_constant in simple_vs and sprite_vs. simple_vs takes its layer
+// from firstInstance and works the depth out from layer_count, so one indirect draw
+// can span layers; sprite_vs gets depth set per batch, since its firstInstance is
+// its first instance.
+struct Vk_Push_Constants {
+    f32 depth;
+    f32 layer_count;
+};
+
+// @NOTE: Host visible, coherent and mapped for its whole life, so the CPU writes
+// into it directly with no staging copy or queue wait. Grows geometrically.
+struct Vk_Mapped_Buffer {
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void *mapped;
+};
+
+// @NOTE: Consecutive batches that share pipeline, clip and vertex buffer, drawn by
+// one multi-draw-indirect call. Commands live in draw_commands or, if indexed, in
+// indexed_draw_commands. Sprite batches are always their own run; culled on the
+// GPU, their command is the one sprite_cull.comp wrote to indirect_buffer.
+struct Vk_Draw_Run {
+    Sort_Key sort_key;
+    Render_Batch_Kind kind;
+    u32 static_batch;       // Static_Batch id, for RENDER_BATCH_STATIC
+    b32 indexed;
+    b32 gpu_culled;
+    u32 first_command;
+    u32 command_count;
+};
+
+// @NOTE: GPU sprite culling, see sprite_cull.comp. A tile is up to VK_CULL_TILE_SIZE
+// sprites of one batch, one workgroup's worth. Layouts match the shader's.
+#define VK_CULL_TILE_SIZE 256
+
+enum Vk_Cull_Pass {
+    VK_CULL_COUNT,
+    VK_CULL_SCAN,
+    VK_CULL_SCATTER,
+};
+
+struct Vk_Cull_Tile {
+    u32 batch;
+    u32 first;
+    u32 count;
+    u32 pad;
+};
+
+struct Vk_Cull_Batch {
+    Rect2 rect;             // world space
+    u32 first;              // instance
+    u32 first_tile;
+    u32 tile_count;
+    u32 pad;
+};
+static_assert(sizeof(Vk_Cull_Batch) == 32, "Vk_Cull_Batch should match Batch in sprite_cull.comp.");
+
+struct Vk_Cull_Push_Constants {
+    u32 pass;
+    u32 count;
+};
+
+// @NOTE: Device copy of a Static_Batch, current as of generation.
+struct Vk_Static_Batch {
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    u32 generation;
 };
 
 struct Vulkan {
@@ -54,15 +126,77 @@ struct Vulkan {
     VkImageView depth_image_view;
     VkDeviceMemory depth_image_memory;
 
-    VkBuffer vertex_buffer;
-    VkDeviceMemory vertex_buffer_memory;
+    Vk_Mapped_Buffer vertex_buffer;
+
+    Vk_Mapped_Buffer quad_buffer;
+
+    Vk_Mapped_Buffer compact_quad_buffer;
+
+    Vk_Mapped_Buffer sprite_buffer;
+
+    // @NOTE: Survivors of sprite_cull.comp, compacted to the front of each batch's
+    // range, and one draw command per sprite batch.
+    VkBuffer culled_sprite_buffer;
+    VkDeviceMemory culled_sprite_buffer_memory;
+    VkDeviceSize culled_sprite_buffer_size;
+
+    Vk_Mapped_Buffer cull_tile_buffer;
+
+    Vk_Mapped_Buffer cull_batch_buffer;
+
+    VkBuffer cull_tile_offset_buffer;
+    VkDeviceMemory cull_tile_offset_buffer_memory;
+    VkDeviceSize cull_tile_offset_buffer_size;
+
+    VkBuffer indirect_buffer;
+    VkDeviceMemory indirect_buffer_memory;
+    VkDeviceSize indirect_buffer_size;
+
+    Vk_Mapped_Buffer clip_mask_buffer;
 
     VkBuffer index_buffer;
     VkDeviceMemory index_buffer_memory;
+    VkDeviceSize index_buffer_size;
 
     VkRenderPass render_pass;
     VkPipelineLayout pipeline_layout;
+    // @NOTE: Translucent (premultiplied blend, no depth write) and opaque variants.
     VkPipeline simple_pipeline;
+    VkPipeline simple_opaque_pipeline;
+    VkPipeline simple_compact_pipeline;
+    VkPipeline simple_compact_opaque_pipeline;
+    VkPipeline sprite_pipeline;
+    VkPipeline sprite_opaque_pipeline;
+    // @NOTE: Writes clip mask stencil bits, no color.
+    VkPipeline clip_mask_pipeline;
+
+    // @NOTE: This frame's draws; see vk_build_draw_runs(). Runs live in
+    // renderer.frame_arena, so they're gone after end_frame. With multiDrawIndirect
+    // the commands are written straight into the mapped command buffers; without
+    // it they go in the frame arena and are issued one by one from there.
+    Vk_Draw_Run *draw_runs;
+    u32 draw_run_count;
+    VkDrawIndirectCommand *draw_commands;
+    u32 draw_command_count;
+    VkDrawIndexedIndirectCommand *indexed_draw_commands;
+    u32 indexed_draw_command_count;
+    Vk_Mapped_Buffer draw_command_buffer;
+    Vk_Mapped_Buffer indexed_draw_command_buffer;
+    b32 multi_draw_indirect;
+
+    // @NOTE: Null if sprite_cull.spv wasn't built.
+    VkPipeline cull_pipeline;
+    VkPipelineLayout cull_pipeline_layout;
+    VkDescriptorSet cull_descriptor_set;
+    Dynamic_Array<Vk_Cull_Tile> cull_tiles;
+    Dynamic_Array<Vk_Cull_Batch> cull_batches;
+    // @NOTE: Host visible; the shader counts survivors into it, read back once the
+    // frame's fence signals.
+    VkBuffer cull_stats_buffer;
+    VkDeviceMemory cull_stats_buffer_memory;
+    u32 *cull_stats_mapped;
+    u32 cull_tested;
+    b32 cull_pending;
 
     VkSemaphore image_available_semaphore;
     VkSemaphore render_finished_semaphore;
@@ -81,4 +215,12 @@ struct Vulkan {
     VkSampler DEBUG_texture_sampler;
 
     Hash_Table<u32, Vk_Image_Unit> image_hash_table;
+    // @NOTE: Destroys for ids whose create is still in this frame's queue; see vk_draw().
+    Dynamic_Array<u32> early_image_destroys;
+    Vk_Image_Unit atlas_pages[RENDERER_ATLAS_PAGE_COUNT];
+    Vk_Static_Batch static_batches[RENDERER_STATIC_BATCH_COUNT];
+
+    VkQueryPool timestamp_pool;
+    f32 timestamp_period;       // ns per tick
+    b32 timestamp_pending;
 };
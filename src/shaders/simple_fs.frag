@@ -1,12 +1,17 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 1) in vec4 f_color;
 layout(location = 2) in vec2 f_uv;
+layout(location = 3) flat in uint f_texture;
 
 layout(location = 0) out vec4 result;
 
-layout(binding = 1) uniform sampler2D texture_sampler;
+// Bindless; indexed by the slot from renderer_register_image().
+layout(binding = 1) uniform sampler2D textures[];
 
 void main() {
-    result = texture(texture_sampler, f_uv) * f_color;
+    // Textures are premultiplied at upload, so the tint is too.
+    vec4 tint = vec4(f_color.rgb * f_color.a, f_color.a);
+    result = texture(textures[nonuniformEXT(f_texture)], f_uv) * tint;
 }
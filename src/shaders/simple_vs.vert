@@ -4,15 +4,26 @@ layout(binding = 0, row_major) uniform Uniform_Buffer_Object {
     mat4 ortho;
 } ubo;
 
+// z from the batch's layer, which the draw passes as firstInstance; same formula
+// as vk_layer_depth().
+layout(push_constant) uniform Push_Constants {
+    float depth;
+    float layer_count;
+} pc;
+
 layout(location = 0) in vec2 v_position;
 layout(location = 1) in vec4 v_color;
 layout(location = 2) in vec2 v_uv;
+layout(location = 3) in uint v_texture;
 
 layout(location = 1) out vec4 f_color;
 layout(location = 2) out vec2 f_uv;
+layout(location = 3) flat out uint f_texture;
 
 void main() {
-    gl_Position = ubo.ortho * vec4(v_position, 0.0, 1.0);
+    float depth = (pc.layer_count - float(gl_InstanceIndex)) / (pc.layer_count + 1.0);
+    gl_Position = ubo.ortho * vec4(v_position, depth, 1.0);
     f_color = v_color;
     f_uv = v_uv;
+    f_texture = v_texture;
 }
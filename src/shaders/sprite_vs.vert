@@ -0,0 +1,45 @@
+#version 450
+
+layout(binding = 0, row_major) uniform Uniform_Buffer_Object {
+    mat4 ortho;
+} ubo;
+
+// z from the batch's layer; see vk_layer_depth(). Instances are sprites here,
+// so the layer can't ride in firstInstance like it does for simple_vs.
+layout(push_constant) uniform Push_Constants {
+    float depth;
+    float layer_count;
+} pc;
+
+// Per-instance; see Sprite_Instance.
+layout(location = 0) in vec2  i_center;
+layout(location = 1) in vec2  i_half_dim;
+layout(location = 2) in vec4  i_uv_rect;
+layout(location = 3) in vec4  i_color;
+layout(location = 4) in uint  i_texture;
+layout(location = 5) in float i_rotation;
+
+layout(location = 1) out vec4 f_color;
+layout(location = 2) out vec2 f_uv;
+layout(location = 3) flat out uint f_texture;
+
+// Same winding as draw_textured_quad().
+const vec2 corners[6] = vec2[](
+    vec2(-1.0,  1.0), vec2( 1.0,  1.0), vec2(-1.0, -1.0),
+    vec2(-1.0, -1.0), vec2( 1.0,  1.0), vec2( 1.0, -1.0)
+);
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+
+    float angle = i_rotation * 6.28318530718;
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 p = corner * i_half_dim;
+    p = vec2(c*p.x - s*p.y, s*p.x + c*p.y);
+
+    gl_Position = ubo.ortho * vec4(i_center + p, pc.depth, 1.0);
+    f_color = i_color;
+    f_uv = mix(i_uv_rect.xy, i_uv_rect.zw, corner*0.5 + 0.5);
+    f_texture = i_texture;
+}
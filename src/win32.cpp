@@ -24,8 +24,12 @@ Os os;
 
 #include "dst.h"
 
+#include "renderer_atlas.h"
 #include "renderer.h"
+#include "renderer_capture.h"
+#include "renderer_hierarchy.h"
 #include "win32_renderer.h"
+#include "win32_memory.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "vendor/stb_image.h"
@@ -86,20 +90,6 @@ win32_window_callback(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     return result;
 }
 
-// @SPEC: ZII
-function
-OS_ALLOC(win32_alloc) {
-    void *result = VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-    return result;
-}
-
-function
-OS_FREE(win32_free) {
-    if (memory) {
-        VirtualFree(memory, 0, MEM_RELEASE);
-    }
-}
-
 function f32
 rand01(void) {
     return ((f32)rand() / RAND_MAX);
@@ -152,21 +142,49 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd) {
     SetForegroundWindow(hwnd);
     SetFocus(hwnd);
 
-    os.alloc = win32_alloc;
-    os.free  = win32_free;
+    os.alloc        = win32_alloc;
+    os.alloc_hinted = win32_alloc_hinted;
+    os.free         = win32_free;
+    os.alloc_stats  = win32_alloc_stats;
+    os.reserve      = win32_reserve;
+    os.commit       = win32_commit;
+    os.release      = win32_release;
 
     Image images[3] = {};
-    images[0].id = 2;
+    images[0].id = ASSET_ID("texture.jpg");
     images[0].data = stbi_load("texture.jpg", (int *)&images[0].width, (int *)&images[0].height, 0, 4);
     ASSERT(images[0].data);
-    images[1].id = 3;
+    images[1].id = ASSET_ID("doggo.png");
     images[1].data = stbi_load("doggo.png", (int *)&images[1].width, (int *)&images[1].height, 0, 4);
     ASSERT(images[1].data);
-    images[2].id = 4;
+    images[2].id = ASSET_ID("doggo2.png");
     images[2].data = stbi_load("doggo2.png", (int *)&images[2].width, (int *)&images[2].height, 0, 4);
     ASSERT(images[2].data);
 
 
+    // @NOTE: The background never changes, so it's built once and drawn by handle.
+    Static_Batch background = create_static_batch();
+    begin_static_batch(background);
+    for (u32 y = 0; y < 32; ++y) {
+        for (u32 x = 0; x < 32; ++x) {
+            v2 center = {64.0f*x + 32.0f, 64.0f*y + 32.0f};
+            draw_textured_quad(center, v2{64, 64}, images[(x + y) % arraycount(images)]);
+        }
+    }
+    end_static_batch();
+
+    // @NOTE: A sun with a planet and its moon; only the rotations change per frame.
+    Transform_Hierarchy hierarchy{};
+    Transform_Node sun = create_node(&hierarchy, Transform_Node{});
+    set_node_sprite(&hierarchy, sun, images[0], v2{96, 96}, v4{1,1,1,1});
+    Transform_Node planet = create_node(&hierarchy, sun);
+    set_node_trs(&hierarchy, planet, v2{160, 0}, 0.0f, v2{0.5f, 0.5f});
+    set_node_sprite(&hierarchy, planet, images[1], v2{96, 96}, v4{1,1,1,1});
+    Transform_Node moon = create_node(&hierarchy, planet);
+    set_node_trs(&hierarchy, moon, v2{120, 0}, 0.0f, v2{0.5f, 0.5f});
+    set_node_sprite(&hierarchy, moon, images[2], v2{96, 96}, v4{1,1,1,1});
+    f32 angle = 0.0f;
+
     while (g_running) 
     {
         MSG msg;
@@ -198,6 +216,12 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd) {
         f32 w  = (f32)rect.right - (f32)rect.left;
         f32 h = (f32)rect.bottom - (f32)rect.top;
 
+        set_view_rect(rect2_min_max(v2{0, 0}, v2{w, h}));
+
+        set_layer(0, false);
+        draw_static_batch(background);
+
+        set_layer(1, false);
         for (u32 i = 0; i < 256; ++i) {
             u32 max_image_index = arraycount(images) - 1;
             u32 image_index = (u32)(rand01()*max_image_index + 0.5f);
@@ -206,8 +230,35 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd) {
             draw_textured_quad(center, dim, images[image_index]);
         }
 
-        renderer_bubblesort();
-        renderer_fill_drawcall_vertex_count();
+        // @NOTE: A panel and a diamond mask nested in it, with a row of quads running
+        // past both.
+        set_layer(2, false);
+        Rect2 panel = rect2_min_dim(v2{0.25f*w, 0.25f*h}, v2{0.5f*w, 0.5f*h});
+        push_clip_rect(panel);
+        for (u32 i = 0; i < 16; ++i) {
+            draw_textured_quad(v2{0.2f*w + (f32)i*0.04f*w, 0.3f*h}, v2{48, 48}, images[i % arraycount(images)]);
+        }
+        v2 c = 0.5f*(panel.min + panel.max);
+        v2 r = 0.4f*(panel.max - panel.min);
+        v2 diamond[6] = {
+            c + v2{0, -r.y}, c + v2{r.x, 0}, c + v2{0, r.y},
+            c + v2{0, -r.y}, c + v2{0, r.y}, c + v2{-r.x, 0},
+        };
+        push_clip_mask(diamond, 2);
+        for (u32 i = 0; i < 16; ++i) {
+            draw_textured_quad(v2{0.2f*w + (f32)i*0.04f*w, c.y}, v2{48, 48}, images[i % arraycount(images)]);
+        }
+        pop_clip();
+        pop_clip();
+
+        set_layer(3, false);
+        angle += 0.01f;
+        set_node_trs(&hierarchy, sun, v2{0.75f*w, 0.75f*h}, angle, v2{1, 1});
+        set_node_rotation(&hierarchy, planet, 3.0f*angle);
+        draw_hierarchy(&hierarchy);
+
+        renderer_sort();
+        renderer_fill_batches();
 
         renderer_function_table.end_frame();
     }
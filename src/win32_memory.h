@@ -0,0 +1,122 @@
+/* ========================================================================
+
+   (C) Copyright 2025 by Sung Woo Lee, All Rights Reserved.
+
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+
+   ======================================================================== */
+
+
+
+
+// @NOTE: os.alloc/os.free and friends on Windows. The exe and the renderer dll
+// each include this and keep their own counters, like linux_memory.h.
+//
+// Still one VirtualAlloc per block, so live and mapped are the same: whole pages.
+// A Win32_Block header in front of each block points at the counters of the module
+// that allocated it, so either side can free the other's blocks and the stats
+// still balance. Blocks are 64-byte aligned.
+#define WIN32_BLOCK_HEADER_SIZE     64
+
+struct Win32_Block {
+    Os_Alloc_Stats *owner;
+    umm mapped_size;
+};
+
+global Os_Alloc_Stats win32_alloc_counters;
+
+function
+OS_ALLOC_STATS(win32_alloc_stats) {
+    Os_Alloc_Stats result = win32_alloc_counters;
+    return result;
+}
+
+// @NOTE: Fills in the header of a fresh allocation and returns the block after it.
+function void *
+win32_count_alloc(void *base) {
+    MEMORY_BASIC_INFORMATION info{};
+    VirtualQuery(base, &info, sizeof(info));
+    Win32_Block *block = (Win32_Block *)base;
+    block->owner       = &win32_alloc_counters;
+    block->mapped_size = info.RegionSize;
+    atomic_add_u64(&win32_alloc_counters.alloc_count, 1);
+    atomic_add_u64((volatile u64 *)&win32_alloc_counters.live_bytes, block->mapped_size);
+    atomic_add_u64(&win32_alloc_counters.mapped_bytes, block->mapped_size);
+    void *result = (u8 *)base + WIN32_BLOCK_HEADER_SIZE;
+    return result;
+}
+
+// @SPEC: ZII
+function
+OS_ALLOC(win32_alloc) {
+    void *base = VirtualAlloc(0, size + WIN32_BLOCK_HEADER_SIZE, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if (!base) {
+        return 0;
+    }
+    return win32_count_alloc(base);
+}
+
+function
+OS_FREE(win32_free) {
+    if (memory) {
+        Win32_Block *block = (Win32_Block *)((u8 *)memory - WIN32_BLOCK_HEADER_SIZE);
+        Os_Alloc_Stats *owner = block->owner;
+        u64 bytes = block->mapped_size;
+        atomic_add_u64(&owner->free_count, 1);
+        atomic_add_u64((volatile u64 *)&owner->live_bytes, (u64)0 - bytes);
+        atomic_add_u64(&owner->mapped_bytes, (u64)0 - bytes);
+        VirtualFree(block, 0, MEM_RELEASE);
+    }
+}
+
+// @NOTE: Windows has no transparent huge pages, so HUGE_PAGES does nothing.
+// HUGETLB asks for large pages, which need SeLockMemoryPrivilege and come
+// committed and resident; without them it falls back to normal pages. Large pages
+// can't be reserved and committed separately, so reserve drops both huge page
+// hints and commit only takes PREFAULT.
+function void
+win32_prefault(void *memory, umm size) {
+    for (volatile u8 *at = (u8 *)memory; at < (u8 *)memory + size; at += 4096) {
+        *at = *at;
+    }
+}
+
+// @SPEC: ZII
+function
+OS_ALLOC_HINTED(win32_alloc_hinted) {
+    umm large_page_size = GetLargePageMinimum();
+    if ((flags & OS_MEMORY_HUGETLB) && large_page_size) {
+        umm large_size = (size + WIN32_BLOCK_HEADER_SIZE + large_page_size - 1) & ~(large_page_size - 1);
+        void *base = VirtualAlloc(0, large_size, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (base) {
+            return win32_count_alloc(base);
+        }
+    }
+    void *result = win32_alloc(size);
+    if (result && (flags & OS_MEMORY_PREFAULT)) {
+        win32_prefault(result, size);
+    }
+    return result;
+}
+
+function
+OS_RESERVE(win32_reserve) {
+    void *result = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+    return result;
+}
+
+function
+OS_COMMIT(win32_commit) {
+    b32 result = (VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != 0);
+    if (result && (flags & OS_MEMORY_PREFAULT)) {
+        win32_prefault(memory, size);
+    }
+    return result;
+}
+
+function
+OS_RELEASE(win32_release) {
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
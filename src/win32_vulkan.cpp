@@ -25,28 +25,17 @@
 
 Os os;
 
+#include "renderer_atlas.h"
 #include "renderer.h"
+#include "renderer_capture.h"
+#include "renderer_hierarchy.h"
 global Renderer renderer;
 
 #include "win32_renderer.h"
+#include "win32_memory.h"
 #include "renderer_vulkan.cpp"
 
 
-// @SPEC: ZII
-function void *
-win32_alloc(umm size) {
-    void *result = VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-    ASSERT(result);
-    return result;
-}
-
-function void
-win32_free(void *memory) {
-    if (memory) {
-        VirtualFree(memory, 0, MEM_RELEASE);
-    }
-}
-
 function void
 win32_vk_create_instance(Vulkan *vk, const char **layers, u32 layer_count) {
     VkApplicationInfo app_info{};
@@ -103,8 +92,8 @@ win32_vk_pick_physical_device_and_create_surface(Vulkan *vk, HWND hwnd, HINSTANC
         u32 queue_family_property_count;
         VkQueueFamilyProperties *queue_family_properties;
         vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_property_count, 0);
-        queue_family_properties = (VkQueueFamilyProperties *)os.alloc(sizeof(queue_family_properties) * queue_family_property_count);
-        SCOPE_EXIT(os.free(queue_family_properties));
+        TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+        queue_family_properties = push_array(&renderer.frame_arena, VkQueueFamilyProperties, queue_family_property_count);
         vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_property_count, queue_family_properties);
 
         Vk_Queue_Family graphics_queue_family{};
@@ -153,8 +142,8 @@ win32_vk_pick_physical_device_and_create_surface(Vulkan *vk, HWND hwnd, HINSTANC
 function void
 win32_vk_pick_best_physical_device_and_create_surface(Vulkan *vk, HWND hwnd, HINSTANCE hinst) {
     u32 physical_device_count = vk_query_physical_device_count(vk->instance);
-    VkPhysicalDevice *physical_devices = (VkPhysicalDevice *)win32_alloc(sizeof(VkPhysicalDevice)*physical_device_count);
-    SCOPE_EXIT(win32_free(physical_devices));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkPhysicalDevice *physical_devices = push_array(&renderer.frame_arena, VkPhysicalDevice, physical_device_count);
     vk_query_physical_devices(vk->instance, physical_devices);
     vk_sort_physical_devices(physical_devices, physical_device_count);
     ASSERT(win32_vk_pick_physical_device_and_create_surface(vk, hwnd, hinst, physical_devices, physical_device_count));
@@ -176,18 +165,27 @@ RENDERER_END_FRAME(win32_end_frame) {
             vk_recreate_swapchain(vk, width, height);
         }
 
+        renderer_capture_frame(width, height);
         vk_draw(vk);
     }
 
-    renderer.sort_keys.clear();
-    renderer.vertices.clear();
-    renderer.drawcall_vertex_count.clear();
+    arena_reset(&renderer.frame_arena);
+
+    // @NOTE: renderer_sort() already merged and cleared the other lists.
+    renderer_clear_draw_list(renderer.draw_lists);
+    renderer.batches.clear();
+    renderer_clear_clips();
 }
 
 WIN32_LOAD_RENDERER(win32_load_renderer) 
 {
-    os.alloc = win32_alloc;
-    os.free  = win32_free;
+    os.alloc        = win32_alloc;
+    os.alloc_hinted = win32_alloc_hinted;
+    os.free         = win32_free;
+    os.alloc_stats  = win32_alloc_stats;
+    os.reserve      = win32_reserve;
+    os.commit       = win32_commit;
+    os.release      = win32_release;
 
     HINSTANCE hinst = GetModuleHandle(0);
 
@@ -199,6 +197,7 @@ WIN32_LOAD_RENDERER(win32_load_renderer)
     Vulkan *vk = (Vulkan *)renderer.backend;
 
     renderer.image_hash_table.init(32);
+    renderer_set_memory_hints(&renderer);
 
 
     const char *desired_layers[] = {
@@ -208,8 +207,8 @@ WIN32_LOAD_RENDERER(win32_load_renderer)
 #endif
     };
     u32 available_layer_count = vk_query_available_layer_count();
-    VkLayerProperties *available_layers = (VkLayerProperties *)win32_alloc(sizeof(VkLayerProperties) * available_layer_count);
-    SCOPE_EXIT(win32_free(available_layers));
+    TEMP_MEMORY_SCOPE(&renderer.frame_arena);
+    VkLayerProperties *available_layers = push_array(&renderer.frame_arena, VkLayerProperties, available_layer_count);
     vk_query_available_layers(available_layers);
     for (u32 i = 0; i < arraycount(desired_layers); ++i) {
         if (!vk_is_layer_available(desired_layers[i], available_layers, available_layer_count)) {